@@ -0,0 +1,85 @@
+#include <exCept.h>
+
+#include "bench.h"
+
+#define BENCH_EXCEPTION 1
+#define BENCH_BATCH_SIZE 64
+
+// `arg` tells whether the callback throws
+BENCH_NOINLINE static void callback(void* arg)
+{
+    if (arg != NULL)
+        THROW(BENCH_EXCEPTION);
+    bench_sink++;
+}
+
+static void on_error(void* arg, EXCEPT_EXCEPTION_TYPE exception)
+{
+    (void)arg;
+    bench_sink += (unsigned long) exception;
+}
+
+// `failing` callbacks out of `BENCH_BATCH_SIZE` throw
+static void make_batch(exC_callback_t* callbacks, unsigned long failing)
+{
+    for (unsigned long i = 0; i < BENCH_BATCH_SIZE; i++)
+    {
+        void* arg = failing != 0 && i % (BENCH_BATCH_SIZE / failing) == 0 ? callbacks : NULL;
+        callbacks[i] = (exC_callback_t) { .fn = callback, .on_error = on_error, .arg = arg };
+    }
+}
+
+// Cost per callback of a `TRY` block around each of them
+static void bench_try_per_callback(unsigned long failing)
+{
+    exC_callback_t callbacks[BENCH_BATCH_SIZE];
+    make_batch(callbacks, failing);
+    unsigned long batches = BENCH_ITERATIONS / BENCH_BATCH_SIZE;
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < batches; i++)
+    {
+        for (unsigned long j = 0; j < BENCH_BATCH_SIZE; j++)
+        {
+            TRY
+            {
+                callbacks[j].fn(callbacks[j].arg);
+            }
+            CATCH()
+            {
+                callbacks[j].on_error(callbacks[j].arg, exC_last_exception());
+            }
+            END_TRY;
+        }
+    }
+    bench_report("try_per_callback", failing, batches * BENCH_BATCH_SIZE, bench_now_ns() - start);
+}
+
+// Cost per callback of `exC_run_batch`, which sets up a single block per batch
+static void bench_run_batch(unsigned long failing)
+{
+    exC_callback_t callbacks[BENCH_BATCH_SIZE];
+    make_batch(callbacks, failing);
+    unsigned long batches = BENCH_ITERATIONS / BENCH_BATCH_SIZE;
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < batches; i++)
+        exC_run_batch(callbacks, BENCH_BATCH_SIZE);
+    bench_report("run_batch", failing, batches * BENCH_BATCH_SIZE, bench_now_ns() - start);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    bench_setup();
+
+    for (unsigned long failing = 0; failing <= 8; failing = failing == 0 ? 1 : failing * 8)
+    {
+        bench_try_per_callback(failing);
+        bench_run_batch(failing);
+    }
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef EXCEPT_BENCH_H
+#define EXCEPT_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <exCept.h>
+
+// Name of the build flavour, set by the Makefile (see `BENCH_VARIANTS`)
+#if !defined(BENCH_VARIANT)
+    #define BENCH_VARIANT "default"
+#endif
+
+#if !defined(BENCH_ITERATIONS)
+    #define BENCH_ITERATIONS 1000000UL
+#endif
+
+// Passed to `exC_global_setup`, and the deepest nesting that is measured
+#if !defined(BENCH_STACK_SIZE)
+    #define BENCH_STACK_SIZE 64
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define BENCH_NOINLINE __attribute__((noinline))
+#else
+    #define BENCH_NOINLINE
+#endif
+
+// Written to from benchmarked blocks so that the compiler can not drop them
+static volatile unsigned long bench_sink;
+
+static inline double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+}
+
+/*
+ * Prints one CSV row: variant,benchmark,param,iterations,ns_per_op
+ * The header is printed once by `make bench`.
+ */
+static inline void bench_report(const char* benchmark, unsigned long param, unsigned long iterations, double elapsed_ns)
+{
+    printf("%s,%s,%lu,%lu,%.2f\n", BENCH_VARIANT, benchmark, param, iterations, elapsed_ns / (double) iterations);
+    fflush(stdout);
+}
+
+// Sets up exCept for the calling thread, and exits if it fails
+static inline void bench_setup(void)
+{
+    if (exC_global_setup(BENCH_STACK_SIZE, 0) || exC_thrd_setup())
+    {
+        fprintf(stderr, "Failed to initialize exCept\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+#endif // EXCEPT_BENCH_H
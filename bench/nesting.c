@@ -0,0 +1,76 @@
+#include <exCept.h>
+
+#include "bench.h"
+
+#define BENCH_EXCEPTION 1
+
+// `depth` nested blocks, the innermost one catching what is thrown from its own `TRY`
+BENCH_NOINLINE static void nest_and_throw(unsigned long depth)
+{
+    TRY
+    {
+        if (depth == 1)
+            THROW(BENCH_EXCEPTION);
+        nest_and_throw(depth - 1);
+    }
+    CATCH(BENCH_EXCEPTION)
+    {
+        bench_sink++;
+    }
+    END_TRY;
+}
+
+// `depth` nested blocks, each one rethrowing to its enclosing block, except for the outermost one
+BENCH_NOINLINE static void rethrow_chain(unsigned long depth, unsigned long level)
+{
+    TRY
+    {
+        if (level == depth)
+            THROW(BENCH_EXCEPTION);
+        rethrow_chain(depth, level + 1);
+    }
+    CATCH(BENCH_EXCEPTION)
+    {
+        if (level != 1)
+            THROW();
+        bench_sink++;
+    }
+    END_TRY;
+}
+
+// Iterations are scaled down with depth, so that every row takes about the same time
+static unsigned long iterations_for(unsigned long depth)
+{
+    return BENCH_ITERATIONS / depth;
+}
+
+static void bench_depth(unsigned long depth)
+{
+    unsigned long iterations = iterations_for(depth);
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < iterations; i++)
+        nest_and_throw(depth);
+    bench_report("throw_at_depth", depth, iterations, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (unsigned long i = 0; i < iterations; i++)
+        rethrow_chain(depth, 1);
+    bench_report("rethrow_chain", depth, iterations, bench_now_ns() - start);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    bench_setup();
+
+    unsigned long depth;
+    for (depth = 1; depth < BENCH_STACK_SIZE; depth *= 2)
+        bench_depth(depth);
+    bench_depth(BENCH_STACK_SIZE);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return 0;
+}
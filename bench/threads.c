@@ -0,0 +1,88 @@
+#include <stdatomic.h>
+#include <threads.h>
+
+#include <exCept.h>
+
+#include "bench.h"
+
+#define DIV_BY_ZERO_EXCEPTION 1
+
+#if defined(EXCEPT_ONE_THREAD)
+    // Only one thread at a time can use exCept
+    #undef BENCH_MAX_THREADS
+    #define BENCH_MAX_THREADS 1
+#elif !defined(BENCH_MAX_THREADS)
+    #define BENCH_MAX_THREADS 8
+#endif
+
+static atomic_bool can_start;
+
+// The pattern of `tests/test1.c` : every other division throws
+BENCH_NOINLINE static double divide(unsigned long a, unsigned long b)
+{
+    if (b == 0)
+        THROW(DIV_BY_ZERO_EXCEPTION, "Division by zero occured in divide() function");
+    return (double) a / (double) b;
+}
+
+static int thread_func(void* arg)
+{
+    (void)arg;
+    exC_thrd_setup();
+    while (!atomic_load(&can_start))
+        thrd_yield();
+    double sum = 0;
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            sum += divide(i, i & 1);
+        }
+        CATCH(DIV_BY_ZERO_EXCEPTION)
+        {
+            sum -= 1;
+        }
+        END_TRY;
+    }
+    bench_sink += (unsigned long) sum;
+    exC_thrd_deinit();
+    return 0;
+}
+
+/*
+ * Every thread runs `BENCH_ITERATIONS` blocks : ns_per_op is the wall time divided by `BENCH_ITERATIONS`, so it stays
+ * flat as long as threads scale.
+ */
+static void bench_threads(int count)
+{
+    thrd_t threads[BENCH_MAX_THREADS];
+    atomic_store(&can_start, false);
+    for (int i = 0; i < count; i++)
+    {
+        if (thrd_create(&threads[i], thread_func, NULL) != thrd_success)
+        {
+            fprintf(stderr, "Failed to create thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    double start = bench_now_ns();
+    atomic_store(&can_start, true);
+    for (int i = 0; i < count; i++)
+        thrd_join(threads[i], NULL);
+    bench_report("threads", (unsigned long) count, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    bench_setup();
+
+    for (int count = 1; count <= BENCH_MAX_THREADS; count *= 2)
+        bench_threads(count);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <exCept.h>
+
+#include "bench.h"
+
+#define BENCH_EXCEPTION 1
+
+BENCH_NOINLINE static void thrower(void)
+{
+    THROW(BENCH_EXCEPTION);
+}
+
+// Cost of entering and leaving a `TRY` block when nothing is thrown
+static void bench_try_no_throw(void)
+{
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            bench_sink++;
+        }
+        CATCH(BENCH_EXCEPTION)
+        {
+            bench_sink--;
+        }
+        END_TRY;
+    }
+    bench_report("try_no_throw", 0, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+// Cost of a `THROW` from a called function to the `CATCH` of the enclosing block
+static void bench_throw_catch(void)
+{
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            thrower();
+        }
+        CATCH(BENCH_EXCEPTION)
+        {
+            bench_sink++;
+        }
+        END_TRY;
+    }
+    bench_report("throw_catch", 1, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+// Cost of entering and leaving a `NOEXCEPT` block
+static void bench_noexcept(void)
+{
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        NOEXCEPT
+        {
+            bench_sink++;
+        }
+        END_NOEXCEPT;
+    }
+    bench_report("noexcept", 0, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+BENCH_NOINLINE static void call(void* arg)
+{
+    if (arg != NULL)
+        THROW(BENCH_EXCEPTION);
+    bench_sink++;
+}
+
+// Cost of `exC_call_result`, with `param` telling whether the function throws
+static void bench_call_result(unsigned long throws)
+{
+    void* arg = throws ? (void*) &bench_call_result : NULL;
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+        bench_sink += exC_call_result(call, arg).code;
+    bench_report("call_result", throws, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    bench_setup();
+
+    bench_try_no_throw();
+    bench_throw_catch();
+    bench_noexcept();
+    bench_call_result(0);
+    bench_call_result(1);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <string.h>
+
+#include <exCept.h>
+
+#include "bench.h"
+
+#define BENCH_EXCEPTION 1
+
+// Large enough for the biggest message measured (the `WHAT` buffer truncates longer ones)
+static char message[4096];
+
+BENCH_NOINLINE static void throw_copy(const char* what)
+{
+    THROW_COPY(BENCH_EXCEPTION, what);
+}
+
+BENCH_NOINLINE static void throw_literal(void)
+{
+    THROW(BENCH_EXCEPTION, "a message that outlives the exception, and does not need to be copied");
+}
+
+BENCH_NOINLINE static void throw_formatted(unsigned long key)
+{
+    THROWF(BENCH_EXCEPTION, "key %lu not found in table '%s'", key, "bench");
+}
+
+struct bench_payload
+{
+    unsigned long key;
+    int line;
+    int column;
+};
+
+BENCH_NOINLINE static void throw_with(unsigned long key)
+{
+    THROW_WITH(BENCH_EXCEPTION, struct bench_payload, ((struct bench_payload){ key, 1, 2 }));
+}
+
+// Cost of a `THROW` whose message of `size` characters has to be copied in the `WHAT` buffer
+static void bench_what_copy(size_t size)
+{
+    memset(message, 'x', size);
+    message[size] = '\0';
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            throw_copy(message);
+        }
+        CATCH(BENCH_EXCEPTION)
+        {
+            bench_sink += (unsigned char) WHAT[0];
+        }
+        END_TRY;
+    }
+    bench_report("what_copy", size, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+static void bench_what_literal(void)
+{
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            throw_literal();
+        }
+        CATCH(BENCH_EXCEPTION)
+        {
+            bench_sink += (unsigned char) WHAT[0];
+        }
+        END_TRY;
+    }
+    bench_report("what_literal", 0, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+// `read` tells whether the message is read (and thus formatted) by the `CATCH` clause
+static void bench_throwf(unsigned long read)
+{
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            throw_formatted(i);
+        }
+        CATCH(BENCH_EXCEPTION)
+        {
+            bench_sink += read ? (unsigned char) WHAT[0] : 1;
+        }
+        END_TRY;
+    }
+    bench_report("throwf", read, BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+// Structured data passed through `THROW_WITH` instead of being formatted in the message
+static void bench_throw_with(void)
+{
+    double start = bench_now_ns();
+    for (unsigned long i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        TRY
+        {
+            throw_with(i);
+        }
+        CATCH_PAYLOAD(BENCH_EXCEPTION, struct bench_payload, payload)
+        {
+            bench_sink += payload->key;
+        }
+        END_TRY;
+    }
+    bench_report("throw_with", sizeof(struct bench_payload), BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+int main(int argc, char const *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    bench_setup();
+
+    bench_what_literal();
+    for (size_t size = 16; size < sizeof(message); size *= 4)
+        bench_what_copy(size);
+    bench_throwf(0);
+    bench_throwf(1);
+    bench_throw_with();
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return 0;
+}
@@ -22,6 +22,24 @@
  * SOFTWARE.
  */
 
+#include "exCept_user_config.h"
+
+#if (defined(EXCEPT_CAPTURE_STACK_TRACE) || defined(EXCEPT_SAMPLING)) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+    // Stack traces and samples are symbolized with `dladdr`
+    #if defined(__linux__) && !defined(_GNU_SOURCE)
+        #define _GNU_SOURCE
+    #endif
+    #define EXCEPT_HAS_DLADDR
+#endif
+
+// Synchronous faults are thrown as exceptions by a handler running on an alternate stack (see `exC_signals_install`)
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+    #if defined(__linux__) && !defined(_GNU_SOURCE)
+        #define _GNU_SOURCE
+    #endif
+    #define EXCEPT_HAS_SIGNALS
+#endif
+
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -29,22 +47,104 @@
 #include <setjmp.h>
 #include <stdnoreturn.h>
 
-#include "exCept_user_config.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 
-// TODO: Use something else than tss, let the user provide it's own mutex type and its own way to distinguish threads, 
-//       and use a custom key-value map implementation to store the exception stack / what buffer for each thread. For
-//       instance, on Raspberry pi pico, user could use the SDK's `mutex_t` type, and use the `get_core_num()` function.
+#if defined(EXCEPT_HAS_SIGNALS)
+    #include <signal.h>
+#endif
 
-// TODO: Provide a `EXCEPT_ONE_THREAD` flag
+// Statistics and the other monitoring features share a per-thread monitor (see `struct exC_monitor`)
+#if defined(EXCEPT_STATS) || defined(EXCEPT_SAMPLING) || defined(EXCEPT_FLIGHT_RECORDER)
+    #define EXCEPT_MONITOR
+#endif
+// Monitors and task groups (see `exC_task_group_create`) are shared between threads
+#include <stdatomic.h>
+#if defined(EXCEPT_SAMPLING) || defined(EXCEPT_FLIGHT_RECORDER)
+    #include <time.h>
+#endif
+// Timestamps of the flight recorder (see `exC_timestamp`)
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    #if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        #include <x86intrin.h>
+    #elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        #include <intrin.h>
+    #endif
+#endif
 
-#if EXCEPT_TERM_HANDLER_ARGC != 1
-    #include <stdarg.h>
+// Throws walk the frame pointers to capture their stack (see `exC_walk_frames`)
+#if (defined(EXCEPT_CAPTURE_STACK_TRACE) || defined(EXCEPT_SAMPLING)) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+    #define EXCEPT_HAS_FRAME_WALK
 #endif
 
 #if !defined(EXCEPT_WHAT_MAX_SIZE)
     #define EXCEPT_WHAT_MAX_SIZE (256 * 2 * 2 * 2)
 #endif
 
+// Size of the alternate stack of each thread calling `exC_signals_install`, on which faults (even stack overflows) are
+// handled
+#if !defined(EXCEPT_SIGNAL_STACK_SIZE)
+    #define EXCEPT_SIGNAL_STACK_SIZE (64 * 1024)
+#endif
+
+// Number of entries of a thread's exception stack when it is created (it then doubles when needed, see `exC_push_stack`)
+#if !defined(EXCEPT_STACK_INITIAL_SIZE)
+    #define EXCEPT_STACK_INITIAL_SIZE 8
+#endif
+
+// Maximum number of arguments (including `*` widths and precisions) captured by `THROWF`
+#if !defined(EXCEPT_WHAT_FMT_MAX_ARGS)
+    #define EXCEPT_WHAT_FMT_MAX_ARGS 8
+#endif
+
+// Space used by `THROWF` to copy the `%s` arguments (each one is truncated to what is left)
+#if !defined(EXCEPT_WHAT_FMT_STRINGS_SIZE)
+    #define EXCEPT_WHAT_FMT_STRINGS_SIZE 256
+#endif
+
+// Maximum number of return addresses captured by each throw, with `EXCEPT_CAPTURE_STACK_TRACE`
+#if !defined(EXCEPT_STACK_TRACE_DEPTH)
+    #define EXCEPT_STACK_TRACE_DEPTH 32
+#endif
+
+// Throw sites tracked by each thread, with `EXCEPT_STATS`
+#if !defined(EXCEPT_STATS_SITES)
+    #define EXCEPT_STATS_SITES 32
+#endif
+
+// Samples each thread keeps until they are drained, with `EXCEPT_SAMPLING` (see `exC_samples_drain`)
+#if !defined(EXCEPT_SAMPLE_RING)
+    #define EXCEPT_SAMPLE_RING 64
+#endif
+// Sample every that many throws from the start (0 : not before `exC_sample_every` or `exC_sample_rate` is called)
+#if !defined(EXCEPT_SAMPLE_EVERY)
+    #define EXCEPT_SAMPLE_EVERY 0
+#endif
+// Largest period reached when sampling at a rate (see `exC_sample_rate`)
+#if !defined(EXCEPT_SAMPLE_MAX_PERIOD)
+    #define EXCEPT_SAMPLE_MAX_PERIOD (1ul << 20)
+#endif
+
+// Initial capacity of the task queue of each thread of a task group (it grows as needed)
+#if !defined(EXCEPT_TASK_QUEUE_SIZE)
+    #define EXCEPT_TASK_QUEUE_SIZE 64
+#endif
+
+// Last events kept by each thread, with `EXCEPT_FLIGHT_RECORDER` (a power of 2)
+#if !defined(EXCEPT_FLIGHT_EVENTS)
+    #define EXCEPT_FLIGHT_EVENTS 16
+#endif
+
+#if defined(EXCEPT_HAS_DLADDR)
+    #include <dlfcn.h>
+    #if defined(__GLIBC__) && !defined(__USE_GNU)
+        // A system header was included before `_GNU_SOURCE` could be defined : addresses are printed as is
+        #undef EXCEPT_HAS_DLADDR
+    #endif
+#endif
+
 #undef THRD_SUCCESS
 #undef TSS_T
 #undef TSS_CREATE
@@ -54,9 +154,68 @@
 #undef ONCE_FLAG
 #undef ONCE_INIT
 #undef CALL_ONCE
+#undef MUTEX_T
+#undef MUTEX_INIT
+#undef MUTEX_DESTROY
+#undef MUTEX_LOCK
+#undef MUTEX_UNLOCK
+#undef THRD_T
+#undef THRD_START_T
+#undef THRD_CALL
+#undef THRD_CREATE
+#undef THRD_JOIN
+#undef THRD_YIELD
+#undef THRD_SLEEP_US
+#undef EXCEPT_HAS_THRD_CREATE
 
 // TODO: Add support for other threading libraries
-#if defined(EXCEPT_USE_THREADS_H) || (!defined(EXCEPT_USE_PTHREADS) && !defined(EXCEPT_USE_WINDOWS_THREADS))
+#if defined(EXCEPT_ONE_THREAD)
+    // Only one thread uses exCept : "thread-specific" data is just a global variable, and no threading library is needed
+    #define THRD_SUCCESS 0
+    #define TSS_T void*
+    #define TSS_CREATE(key, destructor) ((void)(destructor), *(key) = NULL, THRD_SUCCESS)
+    #define TSS_GET(key) (key)
+    static inline int exC_global_set(void** key, void* value)
+    {
+        *key = value;
+        return THRD_SUCCESS;
+    }
+    #define TSS_SET(key, value) exC_global_set(&(key), (value))
+    #define TSS_DELETE(key) ((void)(key))
+    #define ONCE_FLAG bool
+    #define ONCE_INIT false
+    #define CALL_ONCE(flag, func) (*(flag) ? (void)0 : (*(flag) = true, func()))
+    // Task groups run their tasks in the thread that waits for them (see `exC_task_group_create`)
+    #define MUTEX_T bool
+    #define MUTEX_INIT(mutex) (*(mutex) = false, THRD_SUCCESS)
+    #define MUTEX_DESTROY(mutex) ((void)(mutex))
+    #define MUTEX_LOCK(mutex) ((void)(mutex))
+    #define MUTEX_UNLOCK(mutex) ((void)(mutex))
+#elif defined(EXCEPT_USE_CUSTOM_THREADS)
+    /*
+     * The user tells threads apart and provides a mutex (e.g. `get_core_num()` and the SDK's `mutex_t` on a Raspberry
+     * Pi Pico), and thread-specific data is stored in a lock-free map indexed by thread id (see `exC_map_find`)
+     */
+    #if !defined(EXCEPT_CUSTOM_GET_ID) || !defined(EXCEPT_CUSTOM_MUTEX_T) || !defined(EXCEPT_CUSTOM_LOCK) || !defined(EXCEPT_CUSTOM_UNLOCK)
+        #error "EXCEPT_USE_CUSTOM_THREADS requires EXCEPT_CUSTOM_GET_ID, EXCEPT_CUSTOM_MUTEX_T, EXCEPT_CUSTOM_LOCK and EXCEPT_CUSTOM_UNLOCK."
+    #endif
+    #include <stdatomic.h>
+    #define THRD_SUCCESS 0
+    #define TSS_T size_t
+    #define TSS_CREATE(key, destructor) exC_custom_tss_create(key, destructor)
+    #define TSS_GET(key) exC_custom_tss_get(key)
+    #define TSS_SET(key, value) exC_custom_tss_set(key, value)
+    #define TSS_DELETE(key) ((void)(key))
+    #define ONCE_FLAG bool
+    #define ONCE_INIT false
+    #define CALL_ONCE(flag, func) exC_custom_call_once(flag, func)
+    // Threads can not be created : task groups run their tasks in the thread that waits for them
+    #define MUTEX_T bool
+    #define MUTEX_INIT(mutex) (*(mutex) = false, THRD_SUCCESS)
+    #define MUTEX_DESTROY(mutex) ((void)(mutex))
+    #define MUTEX_LOCK(mutex) ((void)(mutex))
+    #define MUTEX_UNLOCK(mutex) ((void)(mutex))
+#elif defined(EXCEPT_USE_THREADS_H) || (!defined(EXCEPT_USE_PTHREADS) && !defined(EXCEPT_USE_WINDOWS_THREADS))
     #include <threads.h>
     // A common return value when success
     #define THRD_SUCCESS thrd_success
@@ -73,6 +232,21 @@
     #define ONCE_FLAG once_flag
     #define ONCE_INIT ONCE_FLAG_INIT
     #define CALL_ONCE(flag, func) call_once(flag, func)
+    // Mutexes and threads of task groups
+    #define MUTEX_T mtx_t
+    #define MUTEX_INIT(mutex) mtx_init(mutex, mtx_plain)
+    #define MUTEX_DESTROY(mutex) mtx_destroy(mutex)
+    #define MUTEX_LOCK(mutex) mtx_lock(mutex)
+    #define MUTEX_UNLOCK(mutex) mtx_unlock(mutex)
+    #define THRD_T thrd_t
+    // Return type and calling convention of the function a thread starts with
+    #define THRD_START_T int
+    #define THRD_CALL
+    #define THRD_CREATE(thread, func, arg) thrd_create(thread, func, arg)
+    #define THRD_JOIN(thread) thrd_join(thread, NULL)
+    #define THRD_YIELD() thrd_yield()
+    #define THRD_SLEEP_US(us) thrd_sleep(&(struct timespec) { .tv_sec = 0, .tv_nsec = (us) * 1000l }, NULL)
+    #define EXCEPT_HAS_THRD_CREATE
 #elif defined(EXCEPT_USE_PTHREADS)
     #include <pthread.h>
     #define THRD_SUCCESS 0
@@ -84,6 +258,21 @@
     #define ONCE_FLAG pthread_once_t
     #define ONCE_INIT PTHREAD_ONCE_INIT
     #define CALL_ONCE(flag, func) pthread_once(flag, func)
+    #include <sched.h>
+    #include <time.h>
+    #define MUTEX_T pthread_mutex_t
+    #define MUTEX_INIT(mutex) pthread_mutex_init(mutex, NULL)
+    #define MUTEX_DESTROY(mutex) pthread_mutex_destroy(mutex)
+    #define MUTEX_LOCK(mutex) pthread_mutex_lock(mutex)
+    #define MUTEX_UNLOCK(mutex) pthread_mutex_unlock(mutex)
+    #define THRD_T pthread_t
+    #define THRD_START_T void*
+    #define THRD_CALL
+    #define THRD_CREATE(thread, func, arg) pthread_create(thread, NULL, func, arg)
+    #define THRD_JOIN(thread) pthread_join(thread, NULL)
+    #define THRD_YIELD() sched_yield()
+    #define THRD_SLEEP_US(us) nanosleep(&(struct timespec) { .tv_sec = 0, .tv_nsec = (us) * 1000l }, NULL)
+    #define EXCEPT_HAS_THRD_CREATE
 #elif defined(EXCEPT_USE_WINDOWS_THREADS)
     // TODO: Test/Improve Windows implementation
     #include <windows.h>
@@ -96,10 +285,160 @@
     #define ONCE_FLAG INIT_ONCE
     #define ONCE_INIT INIT_ONCE_STATIC_INIT
     #define CALL_ONCE(flag, func) InitOnceExecuteOnce(flag, func, NULL, NULL)
+    #define MUTEX_T CRITICAL_SECTION
+    #define MUTEX_INIT(mutex) (InitializeCriticalSection(mutex), THRD_SUCCESS)
+    #define MUTEX_DESTROY(mutex) DeleteCriticalSection(mutex)
+    #define MUTEX_LOCK(mutex) EnterCriticalSection(mutex)
+    #define MUTEX_UNLOCK(mutex) LeaveCriticalSection(mutex)
+    #define THRD_T HANDLE
+    #define THRD_START_T DWORD
+    #define THRD_CALL WINAPI
+    #define THRD_CREATE(thread, func, arg) ((*(thread) = CreateThread(NULL, 0, func, arg, 0, NULL)) == NULL ? 1 : THRD_SUCCESS)
+    #define THRD_JOIN(thread) (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+    #define THRD_YIELD() SwitchToThread()
+    #define THRD_SLEEP_US(us) Sleep(1)
+    #define EXCEPT_HAS_THRD_CREATE
 #else
     // It won't happen because of the fallback when nothing specified
 #endif
 
+#if defined(EXCEPT_USE_CUSTOM_THREADS) && !defined(EXCEPT_ONE_THREAD)
+
+// Maximum number of threads using exCept at the same time
+#if !defined(EXCEPT_CUSTOM_MAX_THREADS)
+    #define EXCEPT_CUSTOM_MAX_THREADS 64
+#endif
+
+// Number of TSS keys created by exCept
+#define EXCEPT_CUSTOM_TSS_KEYS 1
+
+/*
+ * Thread ids are stored shifted by 2, so that 0 marks a slot that has never been used (and ends a lookup), and 1 a slot
+ * that has been released (and is skipped by lookups)
+ */
+#define EXCEPT_MAP_EMPTY ((uintptr_t) 0)
+#define EXCEPT_MAP_RELEASED ((uintptr_t) 1)
+
+struct exC_map_entry
+{
+    atomic_uintptr_t id;
+    // Only accessed by the thread owning the entry
+    void* values[EXCEPT_CUSTOM_TSS_KEYS];
+};
+
+#if defined(EXCEPT_CUSTOM_DIRECT_INDEX)
+    // Ids are between 0 and `EXCEPT_CUSTOM_MAX_THREADS - 1` (core numbers, worker indices, ...) : no hashing needed
+    #define EXCEPT_MAP_SIZE EXCEPT_CUSTOM_MAX_THREADS
+#else
+    // Half full at most, to keep probe sequences short
+    #define EXCEPT_MAP_SIZE (EXCEPT_CUSTOM_MAX_THREADS * 2)
+#endif
+
+static struct exC_map_entry exC_map[EXCEPT_MAP_SIZE];
+static size_t exC_custom_tss_keys = 0;
+#if defined(EXCEPT_CUSTOM_MUTEX_INIT)
+    static EXCEPT_CUSTOM_MUTEX_T exC_custom_mutex = EXCEPT_CUSTOM_MUTEX_INIT;
+#else
+    static EXCEPT_CUSTOM_MUTEX_T exC_custom_mutex;
+#endif
+
+// Finds the entry of the calling thread. If there is none and `insert` is true, claims a free one.
+static struct exC_map_entry* exC_map_find(bool insert)
+{
+    uintptr_t id = (uintptr_t) EXCEPT_CUSTOM_GET_ID() + 2;
+#if defined(EXCEPT_CUSTOM_DIRECT_INDEX)
+    if (id - 2 >= EXCEPT_MAP_SIZE)
+        return NULL;
+    struct exC_map_entry* entry = &exC_map[id - 2];
+    if (atomic_load_explicit(&entry->id, memory_order_acquire) == id)
+        return entry;
+    if (!insert)
+        return NULL;
+    memset(entry->values, 0, sizeof(entry->values));
+    atomic_store_explicit(&entry->id, id, memory_order_release);
+    return entry;
+#else
+    size_t start = (size_t) ((id * (uintptr_t) 2654435761u) % EXCEPT_MAP_SIZE);
+    for (size_t i = 0; i < EXCEPT_MAP_SIZE; ++i)
+    {
+        struct exC_map_entry* entry = &exC_map[(start + i) % EXCEPT_MAP_SIZE];
+        uintptr_t slot_id = atomic_load_explicit(&entry->id, memory_order_acquire);
+        if (slot_id == id)
+            return entry;
+        if (slot_id == EXCEPT_MAP_EMPTY)
+            break;
+    }
+    if (!insert)
+        return NULL;
+    // Only the calling thread inserts its own id, so it can not have been inserted in the meantime
+    for (size_t i = 0; i < EXCEPT_MAP_SIZE; ++i)
+    {
+        struct exC_map_entry* entry = &exC_map[(start + i) % EXCEPT_MAP_SIZE];
+        uintptr_t slot_id = atomic_load_explicit(&entry->id, memory_order_relaxed);
+        if ((slot_id == EXCEPT_MAP_EMPTY || slot_id == EXCEPT_MAP_RELEASED) &&
+            atomic_compare_exchange_strong_explicit(&entry->id, &slot_id, id, memory_order_acq_rel, memory_order_relaxed))
+        {
+            memset(entry->values, 0, sizeof(entry->values));
+            return entry;
+        }
+    }
+    return NULL;
+#endif
+}
+
+/*
+ * Only called through `CALL_ONCE`, which holds the mutex.
+ * There is no way to be notified when a thread exits, so `destructor` is never called : threads have to call
+ * `exC_thrd_deinit` themselves, which also releases their map entry.
+ */
+static int exC_custom_tss_create(size_t* key, void (*destructor)(void*))
+{
+    (void)destructor;
+    if (exC_custom_tss_keys >= EXCEPT_CUSTOM_TSS_KEYS)
+        return 1;
+    *key = exC_custom_tss_keys++;
+    return THRD_SUCCESS;
+}
+
+static void* exC_custom_tss_get(size_t key)
+{
+    struct exC_map_entry* entry = exC_map_find(false);
+    return entry != NULL ? entry->values[key] : NULL;
+}
+
+static int exC_custom_tss_set(size_t key, void* value)
+{
+    struct exC_map_entry* entry = exC_map_find(value != NULL);
+    if (entry == NULL)
+        return value != NULL ? 1 : THRD_SUCCESS;
+    entry->values[key] = value;
+    for (size_t i = 0; i < EXCEPT_CUSTOM_TSS_KEYS; ++i)
+    {
+        if (entry->values[i] != NULL)
+            return THRD_SUCCESS;
+    }
+    // Nothing left for this thread : release the entry for other threads
+#if defined(EXCEPT_CUSTOM_DIRECT_INDEX)
+    atomic_store_explicit(&entry->id, EXCEPT_MAP_EMPTY, memory_order_release);
+#else
+    atomic_store_explicit(&entry->id, EXCEPT_MAP_RELEASED, memory_order_release);
+#endif
+    return THRD_SUCCESS;
+}
+
+static void exC_custom_call_once(bool* flag, void (*func)(void))
+{
+    EXCEPT_CUSTOM_LOCK(&exC_custom_mutex);
+    if (!*flag)
+    {
+        *flag = true;
+        func();
+    }
+    EXCEPT_CUSTOM_UNLOCK(&exC_custom_mutex);
+}
+
+#endif
+
 #if defined(IF_FLAG)
     #undef IF_FLAG
 #endif
@@ -112,17 +451,22 @@
 
 #include "exCept.h"
 
-static bool global_setup_done = false;
-static thread_local bool thread_setup_done = false;
+#if !defined(EXCEPT_CACHE_LINE_SIZE)
+    #define EXCEPT_CACHE_LINE_SIZE 64
+#endif
 
-// "Real" type: jmp_buf**
-static TSS_T stack;
-static ONCE_FLAG stack_once = ONCE_INIT;
-static thread_local bool stack_created = false;
+#if defined(_MSC_VER)
+    #include <malloc.h>
+    #define EXCEPT_ALIGNED_ALLOC(alignment, size) _aligned_malloc(size, alignment)
+    #define EXCEPT_ALIGNED_FREE(ptr) _aligned_free(ptr)
+#else
+    #define EXCEPT_ALIGNED_ALLOC(alignment, size) aligned_alloc(alignment, size)
+    #define EXCEPT_ALIGNED_FREE(ptr) free(ptr)
+#endif
 
-static thread_local volatile size_t stack_top = 0;
-static thread_local volatile EXCEPT_EXCEPTION_TYPE last_exception;
+static bool global_setup_done = false;
 
+// Maximum number of entries of each thread's exception stack
 static size_t stack_size = 0;
 static bool stack_size_set = false;
 
@@ -131,174 +475,2010 @@ static term_handler_t term_handler = &exit;
 static exC_flags_t user_flags = 0;
 
 /*
- * "Real" type: volatile char* volatile
- * Users will be able to optionally provide a string to THROW, something like THROW(<unsigned int error code>, <potential string>).
- * We thus need to store it somehow, so the user could then use a WHAT macro to retrieve it.
+ * Arguments captured by `THROWF`, so that the message is only formatted if someone asks for it (see
+ * `exC_last_exception_what`). Only meaningful while the context's `what` is NULL.
+ */
+enum exC_fmt_arg_kind
+{
+    FMT_ARG_INT,
+    FMT_ARG_LONG,
+    FMT_ARG_LLONG,
+    FMT_ARG_INTMAX,
+    FMT_ARG_SIZE,
+    FMT_ARG_PTRDIFF,
+    FMT_ARG_DOUBLE,
+    FMT_ARG_LDOUBLE,
+    FMT_ARG_PTR,
+    FMT_ARG_STR
+};
+struct exC_fmt_arg
+{
+    enum exC_fmt_arg_kind kind;
+    union
+    {
+        long long i; // Also holds unsigned values : they are converted back before formatting
+        intmax_t imax;
+        double d;
+        long double ld;
+        const void* p;
+        const char* s;
+    } value;
+};
+struct exC_what_fmt
+{
+    const char* fmt;
+    size_t argc;
+    struct exC_fmt_arg args[EXCEPT_WHAT_FMT_MAX_ARGS];
+    char strings[EXCEPT_WHAT_FMT_STRINGS_SIZE];
+};
+
+enum exC_record_kind
+{
+    RECORD_PAYLOAD, // Value thrown with `THROW_WITH`
+    RECORD_CLEANUP, // Function registered with `ON_UNWIND`
+    RECORD_MEMORY,  // Memory allocated with `exC_frame_alloc`
+    RECORD_UNWIND,  // Exception leaving a `CATCH` clause, saved while the block runs its `FINALLY` clause
+    RECORD_DONE     // Cleanup already run
+};
+
+/*
+ * Header of a record of the arena, followed by its data. Records belong to a block, and are released in LIFO order
+ * when it ends (see `exC_release_records`) : the arena only holds the payloads of the `CATCH` clauses currently running,
+ * and the cleanups, memory and exceptions of the blocks they are nested in.
+ */
+struct exC_record
+{
+    struct exC_record* prev;
+    // Stack depth of the block (for payloads, of the catching block)
+    size_t depth;
+    size_t size;
+    enum exC_record_kind kind;
+};
+
+struct exC_cleanup
+{
+    void (*fn)(void*);
+    void* arg;
+};
+
+// Followed by a copy of the message when it was in the `WHAT` buffer
+struct exC_unwind_state
+{
+    EXCEPT_EXCEPTION_TYPE except;
+    const char* what;
+    void* payload;
+    bool what_copied;
+};
+
+// An exception taken out of its thread (see `exC_capture_current`), followed by its payload then its message
+struct exC_captured
+{
+    EXCEPT_EXCEPTION_TYPE except;
+    const char* what;
+    size_t payload_size;
+    bool has_payload;
+#if defined(EXCEPT_CAPTURE_STACK_TRACE)
+    void* trace[EXCEPT_STACK_TRACE_DEPTH];
+    size_t trace_size;
+#endif
+    max_align_t data[];
+};
+
+// Records (and thus payloads) are aligned like `malloc` would
+#define EXCEPT_RECORD_ALIGN(_size) \
+    (((_size) + _Alignof(max_align_t) - 1) / _Alignof(max_align_t) * _Alignof(max_align_t))
+#define EXCEPT_RECORD_DATA(_record) \
+    ((unsigned char*) (_record) + EXCEPT_RECORD_ALIGN(sizeof(struct exC_record)))
+
+/*
+ * State of a `TRY` block, kept in the low bits of its stack entry. A block is catching while its `CATCH` clause runs,
+ * and unwinding when an exception left that clause : it is then resumed with `EXCEPT_UNWINDING` to run its `FINALLY`
+ * clause, and the exception goes on when it ends.
+ */
+enum exC_block_state
+{
+    BLOCK_TRYING = 0,
+    BLOCK_CATCHING = 1,
+    BLOCK_UNWINDING = 2,
+    BLOCK_FINALLY = 3
+};
+#define EXCEPT_BLOCK_STATE_MASK ((uintptr_t) 3)
+static_assert(_Alignof(exC_jmp_buf) > EXCEPT_BLOCK_STATE_MASK, "Not enough alignment to store block states.");
+
+static inline enum exC_block_state exC_block_state(exC_context_t* ctx, size_t index)
+{
+    return (enum exC_block_state) ((uintptr_t) ctx->stack[index] & EXCEPT_BLOCK_STATE_MASK);
+}
+
+static inline void exC_set_block_state(exC_context_t* ctx, size_t index, enum exC_block_state state)
+{
+    ctx->stack[index] = (exC_jmp_buf*) (((uintptr_t) ctx->stack[index] & ~EXCEPT_BLOCK_STATE_MASK) | state);
+}
+
+/*
+ * Everything exCept needs for one thread, in a single allocation. Fields are ordered by how often they are used :
+ * `TRY`, `THROW` and `CATCH` only touch the first cache line, and the second one as long as blocks are not nested
+ * deeper than `EXCEPT_STACK_INITIAL_SIZE`.
+ */
+struct exC_thrd_data
+{
+    _Alignas(EXCEPT_CACHE_LINE_SIZE) exC_context_t ctx;
+    // `ctx.stack` points here until the stack has to grow (see `exC_grow_stack`)
+    _Alignas(EXCEPT_CACHE_LINE_SIZE) exC_jmp_buf* initial_stack[EXCEPT_STACK_INITIAL_SIZE];
+    struct exC_what_fmt what_fmt;
+    _Alignas(max_align_t) unsigned char arena[EXCEPT_ARENA_SIZE];
+    // Users will be able to optionally provide a string to THROW, something like THROW(<unsigned int error code>, <potential string>).
+    // We thus need to store it somehow, so the user could then use a WHAT macro to retrieve it.
+    char what_buffer[EXCEPT_WHAT_MAX_SIZE];
+#if defined(EXCEPT_CAPTURE_STACK_TRACE)
+    // Return addresses captured by the last throw
+    void* trace[EXCEPT_STACK_TRACE_DEPTH];
+    size_t trace_size;
+#endif
+#if defined(EXCEPT_HAS_FRAME_WALK)
+    // Frame of `exC_thrd_setup`, beyond which the stack is not walked
+    void* const* trace_limit;
+#endif
+#if defined(EXCEPT_MONITOR)
+    struct exC_monitor* monitor;
+#endif
+#if defined(EXCEPT_HAS_SIGNALS)
+    // Alternate signal stack of the thread, or NULL (see `exC_signals_install`)
+    void* signal_stack;
+#endif
+};
+static_assert(sizeof(exC_context_t) <= EXCEPT_CACHE_LINE_SIZE, "exC_context_t must fit in a cache line.");
+
+// `ctx` is the first member of `struct exC_thrd_data`
+#define EXCEPT_THRD_DATA(_ctx) ((struct exC_thrd_data*) (_ctx))
+
+#if defined(EXCEPT_HAS_FRAME_WALK)
+/*
+ * Walks the frame records (previous frame pointer, return address) from `frame`, the frame of the throwing function,
+ * and stores up to `max` return addresses in `addresses`.
+ * Code built without frame pointers leaves garbage in the chain : it is only followed upwards, and not beyond the frame
+ * of `exC_thrd_setup`, so that only the live stack of the thread is read.
  */
-static TSS_T last_exception_what;
-static ONCE_FLAG last_exception_what_once = ONCE_INIT;
+static size_t exC_walk_frames(void* const* limit, void* const* frame, void** addresses, size_t max)
+{
+    size_t size = 0;
+    while (size < max && frame <= limit && (uintptr_t) frame % sizeof(void*) == 0)
+    {
+        addresses[size++] = frame[1];
+        void* const* prev = frame[0];
+        if (prev <= frame)
+            break;
+        frame = prev;
+    }
+    return size;
+}
+#define EXCEPT_FRAME_ADDRESS() ((void* const*) __builtin_frame_address(0))
+#define EXCEPT_SET_TRACE_LIMIT(_ctx) (EXCEPT_THRD_DATA(_ctx)->trace_limit = EXCEPT_FRAME_ADDRESS())
+#else
+#define EXCEPT_FRAME_ADDRESS() ((void* const*) NULL)
+#define EXCEPT_SET_TRACE_LIMIT(_ctx) ((void) (_ctx))
+#endif
+
+#if defined(EXCEPT_CAPTURE_STACK_TRACE) && defined(EXCEPT_HAS_FRAME_WALK)
+static void exC_capture_trace(exC_context_t* ctx, void* const* frame)
+{
+    if (ctx == NULL)
+        return;
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    data->trace_size = exC_walk_frames(data->trace_limit, frame, data->trace, EXCEPT_STACK_TRACE_DEPTH);
+}
+#define EXCEPT_CAPTURE_TRACE(_ctx) exC_capture_trace(_ctx, EXCEPT_FRAME_ADDRESS())
+#else
+#define EXCEPT_CAPTURE_TRACE(_ctx) ((void) (_ctx))
+#endif
+
+#if defined(EXCEPT_MONITOR)
+enum exC_event
+{
+    EVENT_THROW,
+    EVENT_CATCH,
+    EVENT_RETHROW,
+    EVENT_TERMINATE,
+    EVENT_COUNT
+};
+
+#if defined(EXCEPT_FLIGHT_RECORDER)
+static_assert((EXCEPT_FLIGHT_EVENTS & (EXCEPT_FLIGHT_EVENTS - 1)) == 0, "EXCEPT_FLIGHT_EVENTS must be a power of 2.");
+
+// Fields are written with relaxed stores, so `exC_print_flight_recorder` can read them while the thread runs
+struct exC_flight_event
+{
+    atomic_ullong time;
+    _Atomic(EXCEPT_EXCEPTION_TYPE) code;
+    _Atomic(const char*) what;
+    atomic_size_t depth;
+    atomic_int event;
+};
+#endif
+
+#if defined(EXCEPT_STATS)
+// A code of 0 marks a free slot
+struct exC_code_counters
+{
+    _Atomic(EXCEPT_EXCEPTION_TYPE) code;
+    atomic_ullong counts[EVENT_COUNT];
+};
+
+// A NULL file marks a free slot. `line` and `code` are written before `file` is published.
+struct exC_site_counters
+{
+    _Atomic(const char*) file;
+    int line;
+    EXCEPT_EXCEPTION_TYPE code;
+    atomic_ullong thrown;
+};
+#endif
+
+/*
+ * Monitoring data of a thread. Only its thread writes it, but other threads read it (see `exC_stats_snapshot`), hence
+ * the relaxed atomics. It outlives the thread : when the thread ends, it goes back to the registry, and the next thread
+ * that starts reuses it (counts keep adding up).
+ */
+struct exC_monitor
+{
+    struct exC_monitor* next;
+    atomic_bool in_use;
+    // Number of the thread, given when it acquires the monitor
+    atomic_ulong thread;
+#if defined(EXCEPT_STATS)
+    // Set by `THROW` right before throwing (see `exC_throw_site`)
+    const char* site_file;
+    int site_line;
+    // Events whose code or site did not fit in the tables
+    atomic_ullong untracked;
+    struct exC_code_counters codes[EXCEPT_STATS_CODES];
+    struct exC_site_counters sites[EXCEPT_STATS_SITES];
+#endif
+#if defined(EXCEPT_SAMPLING)
+    // Sampling settings last seen (see `exC_sample_generation`), throws left before the next sample, and time of the
+    // last sample
+    unsigned generation;
+    unsigned long period;
+    unsigned long long interval;
+    unsigned long countdown;
+    unsigned long long sample_time;
+    // Single-producer single-consumer ring : the thread writes `head`, and the thread that holds `draining` writes `tail`
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_bool draining;
+    exC_sample_t samples[EXCEPT_SAMPLE_RING];
+#endif
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    // Number of events recorded since the thread started (the last `EXCEPT_FLIGHT_EVENTS` ones are kept), and index of
+    // the last throw, whose message is only known once it is stored
+    atomic_size_t flight_next;
+    size_t flight_throw;
+    struct exC_flight_event flight[EXCEPT_FLIGHT_EVENTS];
+#endif
+};
+
+// Every monitor ever allocated, newest first. Monitors are only freed by `exC_global_deinit`.
+static _Atomic(struct exC_monitor*) exC_monitors = NULL;
+
+static atomic_ulong exC_thread_count = 0;
+
+#if defined(EXCEPT_SAMPLING)
+// Set by `exC_sample_every` or `exC_sample_rate`, then `exC_sample_generation` is bumped so threads reload them
+static atomic_ulong exC_sample_period = EXCEPT_SAMPLE_EVERY;
+static atomic_ullong exC_sample_interval = 0;
+static atomic_uint exC_sample_generation = 1;
+#endif
+
+static struct exC_monitor* exC_monitor_acquire(void)
+{
+    struct exC_monitor* monitor = atomic_load_explicit(&exC_monitors, memory_order_acquire);
+    for (; monitor != NULL; monitor = monitor->next)
+    {
+        bool in_use = false;
+        if (atomic_compare_exchange_strong_explicit(&monitor->in_use, &in_use, true, memory_order_acquire, memory_order_relaxed))
+            break;
+    }
+    if (monitor == NULL)
+    {
+        monitor = calloc(1, sizeof(struct exC_monitor));
+        if (monitor == NULL)
+            return NULL;
+        atomic_init(&monitor->in_use, true);
+#if defined(EXCEPT_SAMPLING)
+        atomic_init(&monitor->head, 0);
+        atomic_init(&monitor->tail, 0);
+        atomic_init(&monitor->draining, false);
+#endif
+#if defined(EXCEPT_FLIGHT_RECORDER)
+        atomic_init(&monitor->flight_next, 0);
+#endif
+        monitor->next = atomic_load_explicit(&exC_monitors, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&exC_monitors, &monitor->next, monitor, memory_order_release, memory_order_relaxed))
+            ;
+    }
+    atomic_store_explicit(&monitor->thread, atomic_fetch_add_explicit(&exC_thread_count, 1, memory_order_relaxed) + 1, memory_order_relaxed);
+#if defined(EXCEPT_SAMPLING)
+    // Settings are loaded by the first throw
+    monitor->generation = 0;
+#endif
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    // The events of the previous thread are forgotten
+    atomic_store_explicit(&monitor->flight_next, 0, memory_order_relaxed);
+    monitor->flight_throw = 0;
+#endif
+    return monitor;
+}
+
+static void exC_monitor_release(struct exC_monitor* monitor)
+{
+    if (monitor == NULL)
+        return;
+#if defined(EXCEPT_STATS)
+    monitor->site_file = NULL;
+#endif
+    atomic_store_explicit(&monitor->in_use, false, memory_order_release);
+}
+
+static void exC_monitors_free(void)
+{
+    struct exC_monitor* monitor = atomic_exchange_explicit(&exC_monitors, NULL, memory_order_acquire);
+    while (monitor != NULL)
+    {
+        struct exC_monitor* next = monitor->next;
+        free(monitor);
+        monitor = next;
+    }
+}
+
+// Only the owning thread writes counters : no need for an atomic read-modify-write
+static inline void exC_counter_add(atomic_ullong* counter, unsigned long long n)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+#if defined(EXCEPT_STATS)
+static inline size_t exC_stats_hash(uintmax_t key)
+{
+    return (size_t) ((key ^ (key >> 17)) * 2654435761u);
+}
+
+static struct exC_code_counters* exC_stats_code(struct exC_monitor* monitor, EXCEPT_EXCEPTION_TYPE code)
+{
+    size_t start = exC_stats_hash((uintmax_t) code) % EXCEPT_STATS_CODES;
+    for (size_t i = 0; i < EXCEPT_STATS_CODES; ++i)
+    {
+        struct exC_code_counters* counters = &monitor->codes[(start + i) % EXCEPT_STATS_CODES];
+        EXCEPT_EXCEPTION_TYPE slot = atomic_load_explicit(&counters->code, memory_order_relaxed);
+        if (slot == code)
+            return counters;
+        if (slot == 0)
+        {
+            atomic_store_explicit(&counters->code, code, memory_order_release);
+            return counters;
+        }
+    }
+    return NULL;
+}
+
+static struct exC_site_counters* exC_stats_site(struct exC_monitor* monitor, EXCEPT_EXCEPTION_TYPE code)
+{
+    const char* file = monitor->site_file;
+    int line = monitor->site_line;
+    size_t start = exC_stats_hash((uintptr_t) file ^ (uintmax_t) line) % EXCEPT_STATS_SITES;
+    for (size_t i = 0; i < EXCEPT_STATS_SITES; ++i)
+    {
+        struct exC_site_counters* counters = &monitor->sites[(start + i) % EXCEPT_STATS_SITES];
+        const char* slot = atomic_load_explicit(&counters->file, memory_order_relaxed);
+        if (slot == file && counters->line == line)
+            return counters;
+        if (slot == NULL)
+        {
+            counters->line = line;
+            counters->code = code;
+            atomic_store_explicit(&counters->file, file, memory_order_release);
+            return counters;
+        }
+    }
+    return NULL;
+}
+#endif
+
+#if defined(EXCEPT_SAMPLING)
+static unsigned long long exC_time_ns(void)
+{
+    struct timespec time;
+    if (timespec_get(&time, TIME_UTC) != TIME_UTC)
+        return 0;
+    return (unsigned long long) time.tv_sec * 1000000000u + (unsigned long long) time.tv_nsec;
+}
+
+// Counts a throw, and samples it if its turn has come. `frame` is the frame of the throwing function.
+static void exC_sample_throw(exC_context_t* ctx, struct exC_monitor* monitor, EXCEPT_EXCEPTION_TYPE except, void* const* frame)
+{
+    unsigned generation = atomic_load_explicit(&exC_sample_generation, memory_order_acquire);
+    if (monitor->generation != generation)
+    {
+        monitor->generation = generation;
+        monitor->interval = atomic_load_explicit(&exC_sample_interval, memory_order_relaxed);
+        monitor->period = monitor->interval != 0 ? 1 : atomic_load_explicit(&exC_sample_period, memory_order_relaxed);
+        monitor->countdown = monitor->period;
+        monitor->sample_time = 0;
+    }
+    if (monitor->period == 0 || --monitor->countdown != 0)
+        return;
+    unsigned long long now = exC_time_ns();
+    if (monitor->interval != 0)
+    {
+        // Scale the period so that the next sample comes `interval` after this one, if throws keep the same pace
+        if (monitor->sample_time != 0 && now > monitor->sample_time)
+        {
+            double period = (double) monitor->period * (double) monitor->interval / (double) (now - monitor->sample_time);
+            monitor->period = period < 1 ? 1 : period > EXCEPT_SAMPLE_MAX_PERIOD ? EXCEPT_SAMPLE_MAX_PERIOD : (unsigned long) period;
+        }
+        monitor->sample_time = now;
+    }
+    monitor->countdown = monitor->period;
+
+    size_t head = atomic_load_explicit(&monitor->head, memory_order_relaxed);
+    // The sample is lost if the ring was not drained in time
+    if (head - atomic_load_explicit(&monitor->tail, memory_order_acquire) == EXCEPT_SAMPLE_RING)
+        return;
+    exC_sample_t* sample = &monitor->samples[head % EXCEPT_SAMPLE_RING];
+    sample->code = except;
+    sample->time = now;
+    sample->thread = atomic_load_explicit(&monitor->thread, memory_order_relaxed);
+#if defined(EXCEPT_HAS_FRAME_WALK)
+    sample->depth = exC_walk_frames(EXCEPT_THRD_DATA(ctx)->trace_limit, frame, sample->frames, EXCEPT_SAMPLE_DEPTH);
+#else
+    (void)ctx;
+    (void)frame;
+    sample->depth = 0;
+#endif
+    atomic_store_explicit(&monitor->head, head + 1, memory_order_release);
+}
+#endif
+
+#if defined(EXCEPT_FLIGHT_RECORDER)
+// Raw time stamp counter where it can be read cheaply, nanoseconds elsewhere
+static inline unsigned long long exC_timestamp(void)
+{
+#if ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))) \
+    || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+    return __rdtsc();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    unsigned long long ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+    return (unsigned long long) time.tv_sec * 1000000000u + (unsigned long long) time.tv_nsec;
+#endif
+}
+
+// Message of the current exception, without formatting a `THROWF` message
+static inline const char* exC_flight_what(exC_context_t* ctx)
+{
+    return ctx->what != NULL ? ctx->what : EXCEPT_THRD_DATA(ctx)->what_fmt.fmt;
+}
+
+// Overwrites the oldest event of the ring, without branching (throws fill in their message later, see `EXCEPT_FLIGHT_WHAT`)
+static inline void exC_flight_record(exC_context_t* ctx, struct exC_monitor* monitor, enum exC_event event, EXCEPT_EXCEPTION_TYPE except)
+{
+    size_t next = atomic_load_explicit(&monitor->flight_next, memory_order_relaxed);
+    struct exC_flight_event* entry = &monitor->flight[next & (EXCEPT_FLIGHT_EVENTS - 1)];
+    atomic_store_explicit(&entry->time, exC_timestamp(), memory_order_relaxed);
+    atomic_store_explicit(&entry->code, except, memory_order_relaxed);
+    // The message of a throw is not stored yet
+    bool throwing = event == EVENT_THROW || event == EVENT_TERMINATE;
+    atomic_store_explicit(&entry->what, throwing ? NULL : exC_flight_what(ctx), memory_order_relaxed);
+    atomic_store_explicit(&entry->depth, ctx->top, memory_order_relaxed);
+    atomic_store_explicit(&entry->event, (int) event, memory_order_relaxed);
+    monitor->flight_throw = event == EVENT_THROW ? next : monitor->flight_throw;
+    atomic_store_explicit(&monitor->flight_next, next + 1, memory_order_release);
+}
+
+// Stores the message of the exception being thrown in its event
+static void exC_flight_what_stored(exC_context_t* ctx)
+{
+    struct exC_monitor* monitor = EXCEPT_THRD_DATA(ctx)->monitor;
+    if (monitor != NULL)
+    {
+        struct exC_flight_event* entry = &monitor->flight[monitor->flight_throw & (EXCEPT_FLIGHT_EVENTS - 1)];
+        atomic_store_explicit(&entry->what, exC_flight_what(ctx), memory_order_relaxed);
+    }
+}
+#define EXCEPT_FLIGHT_WHAT(_ctx) exC_flight_what_stored(_ctx)
+#else
+#define EXCEPT_FLIGHT_WHAT(_ctx) ((void) (_ctx))
+#endif
+
+// Records an event of the current exception (`except` for throws, which have not stored it yet, and `frame` for
+// throws, the frame of the throwing function)
+static void exC_monitor_event(exC_context_t* ctx, enum exC_event event, EXCEPT_EXCEPTION_TYPE except, void* const* frame)
+{
+    struct exC_monitor* monitor = ctx != NULL ? EXCEPT_THRD_DATA(ctx)->monitor : NULL;
+    if (monitor == NULL)
+        return;
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    exC_flight_record(ctx, monitor, event, except);
+#endif
+#if defined(EXCEPT_SAMPLING)
+    if (event == EVENT_THROW)
+        exC_sample_throw(ctx, monitor, except, frame);
+#else
+    (void)frame;
+#endif
+#if defined(EXCEPT_STATS)
+    struct exC_code_counters* code = exC_stats_code(monitor, except);
+    if (code != NULL)
+        exC_counter_add(&code->counts[event], 1);
+    else
+        exC_counter_add(&monitor->untracked, 1);
+    if (event == EVENT_THROW && monitor->site_file != NULL)
+    {
+        struct exC_site_counters* site = exC_stats_site(monitor, except);
+        if (site != NULL)
+            exC_counter_add(&site->thrown, 1);
+        else
+            exC_counter_add(&monitor->untracked, 1);
+        monitor->site_file = NULL;
+    }
+#endif
+}
+#define EXCEPT_MONITOR_EVENT(_ctx, _event, _except) \
+    exC_monitor_event(_ctx, _event, _except, (_event) == EVENT_THROW ? EXCEPT_FRAME_ADDRESS() : NULL)
+#else
+#define EXCEPT_MONITOR_EVENT(_ctx, _event, _except) ((void) (_ctx), (void) (_except))
+#define EXCEPT_FLIGHT_WHAT(_ctx) ((void) (_ctx))
+#endif
+
+// "Real" type: struct exC_thrd_data*
+// The context is also cached in `exC_current_context` (when there is thread-local storage), so TSS is mostly used to
+// free it when the thread exits
+static TSS_T context;
+static ONCE_FLAG context_once = ONCE_INIT;
+
+#if !defined(EXCEPT_USE_CUSTOM_THREADS) || defined(EXCEPT_ONE_THREAD)
+EXCEPT_API EXCEPT_THREAD_LOCAL exC_context_t* exC_current_context = NULL;
+#endif
+
+static inline void exC_set_stack_size(size_t size);
+static inline int exC_create_context(void);
+
+static void context_tss_create(void);
+static void context_tss_free(void* ptr);
+#if defined(EXCEPT_HAS_SIGNALS)
+static void exC_signal_stack_free(struct exC_thrd_data* data);
+#endif
+
+EXCEPT_API
+int exC_is_global_setup_done(void)
+{
+    return global_setup_done && stack_size_set ? 1 : 0;
+}
+
+EXCEPT_API
+int exC_is_thread_setup_done(void)
+{
+    return EXCEPT_CONTEXT() != NULL ? 1 : 0;
+}
+
+EXCEPT_API
+int exC_global_setup(size_t stack_size, exC_flags_t flags)
+{
+    if (global_setup_done)
+        return 0;
+    user_flags = flags;
+    exC_set_stack_size(stack_size);
+    global_setup_done = true;
+    return 0;
+}
+
+EXCEPT_API
+int exC_thrd_setup(void)
+{
+    if (!global_setup_done)
+        return -1;
+    if (EXCEPT_CONTEXT() != NULL)
+        return 0;
+    CALL_ONCE(&context_once, context_tss_create);
+    if (exC_create_context() != 0)
+        return -1;
+    EXCEPT_SET_TRACE_LIMIT(EXCEPT_CONTEXT());
+    return 0;
+}
+
+static inline void exC_set_stack_size(size_t size)
+{
+    if (stack_size_set)
+        return;
+    stack_size = size;
+    stack_size_set = true;
+}
+
+EXCEPT_API
+int exC_is_stack_size_set(void)
+{
+    return stack_size_set ? 1 : 0;
+}
+
+EXCEPT_API
+int exC_is_stack_created(void)
+{
+    return EXCEPT_CONTEXT() != NULL ? 1 : 0;
+}
+
+EXCEPT_API
+exC_context_t* exC_get_context(void)
+{
+#if defined(EXCEPT_USE_CUSTOM_THREADS) && !defined(EXCEPT_ONE_THREAD)
+    struct exC_thrd_data* data = TSS_GET(context);
+    return data != NULL ? &data->ctx : NULL;
+#else
+    return exC_current_context;
+#endif
+}
+
+// Allocates and initializes a context, bound to no thread. Returns NULL if it can not be allocated.
+static struct exC_thrd_data* exC_alloc_context(void)
+{
+    if (!stack_size_set)
+        return NULL;
+    struct exC_thrd_data* data = EXCEPT_ALIGNED_ALLOC(EXCEPT_CACHE_LINE_SIZE, sizeof(struct exC_thrd_data));
+    if (data == NULL)
+        return NULL;
+    // Start small : most threads never nest deeply
+    data->ctx.stack = data->initial_stack;
+    data->ctx.top = 0;
+    data->ctx.size = stack_size < EXCEPT_STACK_INITIAL_SIZE ? stack_size : EXCEPT_STACK_INITIAL_SIZE;
+    data->ctx.last_exception = 0;
+    data->ctx.what = "";
+    data->ctx.payload = NULL;
+    data->ctx.records = NULL;
+#if defined(EXCEPT_CAPTURE_STACK_TRACE)
+    data->trace_size = 0;
+#endif
+#if defined(EXCEPT_HAS_FRAME_WALK)
+    // Set by `exC_thrd_setup`. Until then, no frame is walked.
+    data->trace_limit = NULL;
+#endif
+#if defined(EXCEPT_MONITOR)
+    // Without a monitor, the thread is just not monitored
+    data->monitor = exC_monitor_acquire();
+#endif
+#if defined(EXCEPT_HAS_SIGNALS)
+    data->signal_stack = NULL;
+#endif
+    return data;
+}
+
+static inline int exC_create_context(void)
+{
+    struct exC_thrd_data* data = exC_alloc_context();
+    if (data == NULL)
+        return -1;
+    if (TSS_SET(context, data) != THRD_SUCCESS)
+    {
+#if defined(EXCEPT_MONITOR)
+        exC_monitor_release(data->monitor);
+#endif
+        EXCEPT_ALIGNED_FREE(data);
+        return -1;
+    }
+#if !defined(EXCEPT_USE_CUSTOM_THREADS) || defined(EXCEPT_ONE_THREAD)
+    exC_current_context = &data->ctx;
+#endif
+    return 0;
+}
+
+EXCEPT_API
+exC_context_t* exC_ctx_create(void)
+{
+    if (!global_setup_done)
+        return NULL;
+    struct exC_thrd_data* data = exC_alloc_context();
+    return data != NULL ? &data->ctx : NULL;
+}
+
+EXCEPT_API
+exC_context_t* exC_ctx_switch(exC_context_t* ctx)
+{
+#if defined(EXCEPT_USE_CUSTOM_THREADS) && !defined(EXCEPT_ONE_THREAD)
+    // The context map is the only place where the current context is kept (it is left as is if the map is full)
+    exC_context_t* previous = exC_get_context();
+    (void) TSS_SET(context, ctx != NULL ? EXCEPT_THRD_DATA(ctx) : NULL);
+    return previous;
+#else
+    // The TSS key keeps the context of the thread, to free it when the thread exits
+    exC_context_t* previous = exC_current_context;
+    exC_current_context = ctx;
+    return previous;
+#endif
+}
+
+EXCEPT_API
+void exC_ctx_destroy(exC_context_t* ctx)
+{
+    if (ctx == NULL)
+        return;
+    context_tss_free(EXCEPT_THRD_DATA(ctx));
+}
+
+// Doubles the capacity of the exception stack, up to `stack_size`. Returns false if it can not grow anymore.
+static bool exC_grow_stack(exC_context_t* ctx)
+{
+    if (ctx->size >= stack_size)
+        return false;
+    size_t new_size = ctx->size * 2 < stack_size ? ctx->size * 2 : stack_size;
+    // Entries only point to the `jmp_buf`s of the `TRY` blocks, so they can be moved around
+    exC_jmp_buf** initial_stack = EXCEPT_THRD_DATA(ctx)->initial_stack;
+    exC_jmp_buf** new_stack = ctx->stack == initial_stack ? malloc(new_size * sizeof(exC_jmp_buf*))
+                                                          : realloc(ctx->stack, new_size * sizeof(exC_jmp_buf*));
+    if (new_stack == NULL)
+        return false;
+    if (ctx->stack == initial_stack)
+        memcpy(new_stack, initial_stack, ctx->size * sizeof(exC_jmp_buf*));
+    ctx->stack = new_stack;
+    ctx->size = new_size;
+    return true;
+}
+
+EXCEPT_API
+int exC_push_stack(exC_jmp_buf* env)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL)
+        return -1;
+    if (ctx->top >= ctx->size && !exC_grow_stack(ctx))
+    {
+        // The enclosing blocks are still there : let them recover
+        if (ctx->top == 0)
+        {
+            fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception stack overflow.\n");
+            exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        }
+        exC_unwind_static(EXCEPT_STACK_OVERFLOW, "Exception stack overflow");
+    }
+    ctx->stack[ctx->top++] = env;
+    return 0;
+}
+
+// Largest record which still fits on top of the arena
+static size_t exC_arena_left(exC_context_t* ctx)
+{
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    struct exC_record* prev = ctx->records;
+    size_t used = prev != NULL ? (size_t) (EXCEPT_RECORD_DATA(prev) - data->arena) + EXCEPT_RECORD_ALIGN(prev->size) : 0;
+    size_t header = EXCEPT_RECORD_ALIGN(sizeof(struct exC_record));
+    if (header > EXCEPT_ARENA_SIZE - used)
+        return 0;
+    return (EXCEPT_ARENA_SIZE - used - header) / _Alignof(max_align_t) * _Alignof(max_align_t);
+}
+
+// Bump-allocates a record for the innermost block, on top of the arena. Returns NULL if the arena is full.
+static struct exC_record* exC_push_record(exC_context_t* ctx, enum exC_record_kind kind, size_t size)
+{
+    if (size > exC_arena_left(ctx))
+        return NULL;
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    struct exC_record* prev = ctx->records;
+    size_t used = prev != NULL ? (size_t) (EXCEPT_RECORD_DATA(prev) - data->arena) + EXCEPT_RECORD_ALIGN(prev->size) : 0;
+    struct exC_record* record = (struct exC_record*) (data->arena + used);
+    record->prev = prev;
+    record->depth = ctx->top;
+    record->size = size;
+    record->kind = kind;
+    ctx->records = record;
+    return record;
+}
+
+enum exC_release_mode
+{
+    RELEASE_DROP,    // A new exception is thrown
+    RELEASE_RETHROW, // The current exception is thrown again : its payload is kept
+    RELEASE_POP      // A block ends : if it was unwinding, its exception is restored (and its payload kept)
+};
+
+/*
+ * Releases the records of the blocks deeper than `depth`, running their cleanups. Returns true if one of them was
+ * unwinding (`RELEASE_POP` only).
+ */
+static bool exC_release_records(exC_context_t* ctx, size_t depth, enum exC_release_mode mode)
+{
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    struct exC_record* kept = NULL;
+    bool resumed = false;
+    struct exC_record* record = ctx->records;
+    while (record != NULL && record->depth > depth)
+    {
+        struct exC_record* prev = record->prev;
+        switch (record->kind)
+        {
+            case RECORD_PAYLOAD:
+                if (record == ctx->payload)
+                {
+                    if (mode == RELEASE_RETHROW || resumed)
+                        kept = record;
+                    else
+                        ctx->payload = NULL;
+                }
+                break;
+            case RECORD_CLEANUP:
+            {
+                struct exC_cleanup cleanup = *(struct exC_cleanup*) EXCEPT_RECORD_DATA(record);
+                // While the cleanup runs, the arena ends at this record (or at the kept payload, if it is above) : what
+                // it allocates can not overwrite the records left, and the blocks it uses do not release them
+                record->kind = RECORD_DONE;
+                record->depth = depth;
+                struct exC_record* fence = record;
+                if (kept != NULL && kept > record)
+                {
+                    kept->prev = record;
+                    kept->depth = depth;
+                    fence = kept;
+                }
+                ctx->records = fence;
+                EXCEPT_EXCEPTION_TYPE except = ctx->last_exception;
+                const char* what = ctx->what;
+                void* payload = ctx->payload;
+                cleanup.fn(cleanup.arg);
+                ctx->last_exception = except;
+                ctx->what = what;
+                ctx->payload = payload;
+                break;
+            }
+            case RECORD_UNWIND:
+                if (mode == RELEASE_POP)
+                {
+                    struct exC_unwind_state* state = (struct exC_unwind_state*) EXCEPT_RECORD_DATA(record);
+                    ctx->last_exception = state->except;
+                    ctx->payload = state->payload;
+                    if (state->what_copied)
+                    {
+                        strcpy(data->what_buffer, (const char*) (state + 1));
+                        ctx->what = data->what_buffer;
+                    }
+                    else
+                        ctx->what = state->what;
+                    resumed = true;
+                }
+                break;
+            case RECORD_MEMORY:
+            case RECORD_DONE:
+                break;
+        }
+        record = prev;
+    }
+    if (kept != NULL)
+    {
+        // The payload stays where it is, and now belongs to the block catching its exception
+        kept->prev = record;
+        kept->depth = depth;
+        record = kept;
+    }
+    ctx->records = record;
+    return resumed;
+}
+
+// Only its address is used (see `NOEXCEPT`)
+EXCEPT_API max_align_t exC_noexcept_marker;
+
+/*
+ * Finds the innermost block able to handle an exception, and marks it, or terminates if a `NOEXCEPT` block comes first.
+ * A block whose `CATCH` clause is running is resumed to run its `FINALLY` clause, while a block running its `FINALLY`
+ * clause is left as is. `keep_payload` tells whether the current payload is still needed (rethrow), in which case it is
+ * handed over to the block. `except` is the exception being thrown, only used for diagnostics.
+ */
+static exC_jmp_buf* exC_handler_env(exC_context_t* ctx, bool keep_payload, EXCEPT_EXCEPTION_TYPE except)
+{
+    size_t top = ctx != NULL ? ctx->top : 0;
+    while (top != 0)
+    {
+        if (ctx->stack[top - 1] == EXCEPT_NOEXCEPT_FRAME)
+        {
+            EXCEPT_MONITOR_EVENT(ctx, EVENT_TERMINATE, except);
+            fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception thrown from a NOEXCEPT block.\n");
+            exC_print_stack_trace(stderr);
+            exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        }
+        enum exC_block_state state = exC_block_state(ctx, top - 1);
+        if (state == BLOCK_TRYING || state == BLOCK_CATCHING)
+        {
+            exC_set_block_state(ctx, top - 1, state == BLOCK_TRYING ? BLOCK_CATCHING : BLOCK_UNWINDING);
+            struct exC_record* payload = ctx->payload;
+            // Only the innermost record can be the current payload of a rethrown exception
+            if (keep_payload && payload != NULL && payload == ctx->records)
+                payload->depth = top;
+            return (exC_jmp_buf*) ((uintptr_t) ctx->stack[top - 1] & ~EXCEPT_BLOCK_STATE_MASK);
+        }
+        ctx->top = --top;
+        if (ctx->records != NULL)
+            exC_release_records(ctx, top, keep_payload ? RELEASE_RETHROW : RELEASE_DROP);
+    }
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_TERMINATE, except);
+    fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception has been thrown without initializing the exception stack.\n");
+    exC_print_stack_trace(stderr);
+    exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+}
+
+// Saves the exception leaving the `CATCH` clause of the innermost block, until the block ends
+static void exC_save_unwinding(exC_context_t* ctx)
+{
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    // The `FINALLY` clause may throw other exceptions : the message must not stay in the `WHAT` buffer
+    const char* what = exC_last_exception_what();
+    bool copy = what == data->what_buffer;
+    size_t length = copy ? strlen(what) : 0;
+    size_t left = exC_arena_left(ctx);
+    // The copy is truncated to what is left of the arena rather than losing the exception
+    if (copy && sizeof(struct exC_unwind_state) + length + 1 > left && left > sizeof(struct exC_unwind_state))
+        length = left - sizeof(struct exC_unwind_state) - 1;
+    size_t size = sizeof(struct exC_unwind_state) + (copy ? length + 1 : 0);
+    struct exC_record* record = exC_push_record(ctx, RECORD_UNWIND, size);
+    if (record == NULL)
+    {
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception arena overflow.\n");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+    struct exC_unwind_state* state = (struct exC_unwind_state*) EXCEPT_RECORD_DATA(record);
+    state->except = ctx->last_exception;
+    state->what = what;
+    state->payload = ctx->payload;
+    state->what_copied = copy;
+    if (copy)
+    {
+        memcpy(state + 1, what, length);
+        ((char*) (state + 1))[length] = '\0';
+    }
+}
+
+#if defined(EXCEPT_USE_FAST_CONTEXT)
+/*
+ * `exC_fast_setjmp` stores what `exC_fast_longjmp` needs to resume its caller as if it had just returned (with 1
+ * instead of 0). Only what the ABI requires a function to preserve is stored, the other registers being already lost
+ * for the caller.
+ */
+#if defined(__APPLE__)
+    #define EXCEPT_ASM_FUNCTION(_name) ".globl _" #_name "\n.p2align 4\n_" #_name ":\n"
+    #define EXCEPT_ASM_END(_name) ""
+#else
+    #define EXCEPT_ASM_FUNCTION(_name) ".globl " #_name "\n.type " #_name ", %function\n.p2align 4\n" #_name ":\n"
+    #define EXCEPT_ASM_END(_name) ".size " #_name ", .-" #_name "\n"
+#endif
+#if defined(__x86_64__)
+    #if defined(__CET__) && (__CET__ & 1)
+        // Indirect branch tracking : both functions may be called through the PLT
+        #define EXCEPT_ASM_ENTRY "endbr64\n"
+    #else
+        #define EXCEPT_ASM_ENTRY ""
+    #endif
+    #if defined(__CET__) && (__CET__ & 2)
+        // The shadow stack pointer is saved, and the shadow stack unwound up to it (by at most 255 entries at a time),
+        // plus the return address of `exC_fast_setjmp`. `rdsspq` does nothing when shadow stacks are not enabled.
+        #define EXCEPT_ASM_SAVE_SSP "xorl %eax, %eax\nrdsspq %rax\nmovq %rax, 64(%rdi)\n"
+        #define EXCEPT_ASM_RESTORE_SSP                                                  \
+            "xorl %eax, %eax\nrdsspq %rax\ntestq %rax, %rax\njz 2f\n"                   \
+            "subq 64(%rdi), %rax\nnegq %rax\nshrq $3, %rax\naddq $1, %rax\n"            \
+            "movl $255, %ebx\n"                                                         \
+            "1:\ncmpq %rbx, %rax\ncmovb %rax, %rbx\nincsspq %rbx\nsubq %rbx, %rax\nja 1b\n2:\n"
+    #else
+        #define EXCEPT_ASM_SAVE_SSP ""
+        #define EXCEPT_ASM_RESTORE_SSP ""
+    #endif
+__asm__(
+    ".text\n"
+    EXCEPT_ASM_FUNCTION(exC_fast_setjmp)
+    EXCEPT_ASM_ENTRY
+    "movq %rbx, 0(%rdi)\n"
+    "movq %rbp, 8(%rdi)\n"
+    "movq %r12, 16(%rdi)\n"
+    "movq %r13, 24(%rdi)\n"
+    "movq %r14, 32(%rdi)\n"
+    "movq %r15, 40(%rdi)\n"
+    // The stack pointer of the caller, once returned
+    "leaq 8(%rsp), %rdx\n"
+    "movq %rdx, 48(%rdi)\n"
+    "movq (%rsp), %rdx\n"
+    "movq %rdx, 56(%rdi)\n"
+    EXCEPT_ASM_SAVE_SSP
+    "xorl %eax, %eax\n"
+    "ret\n"
+    EXCEPT_ASM_END(exC_fast_setjmp)
+    EXCEPT_ASM_FUNCTION(exC_fast_longjmp)
+    EXCEPT_ASM_ENTRY
+    EXCEPT_ASM_RESTORE_SSP
+    "movq 0(%rdi), %rbx\n"
+    "movq 8(%rdi), %rbp\n"
+    "movq 16(%rdi), %r12\n"
+    "movq 24(%rdi), %r13\n"
+    "movq 32(%rdi), %r14\n"
+    "movq 40(%rdi), %r15\n"
+    "movq 48(%rdi), %rsp\n"
+    "movl $1, %eax\n"
+    "jmpq *56(%rdi)\n"
+    EXCEPT_ASM_END(exC_fast_longjmp)
+);
+#elif defined(__aarch64__)
+    #if defined(__ARM_FEATURE_BTI_DEFAULT)
+        // `bti c` : both functions may be called through the PLT
+        #define EXCEPT_ASM_ENTRY "hint #34\n"
+    #else
+        #define EXCEPT_ASM_ENTRY ""
+    #endif
+__asm__(
+    ".text\n"
+    EXCEPT_ASM_FUNCTION(exC_fast_setjmp)
+    EXCEPT_ASM_ENTRY
+    "stp x19, x20, [x0, #0]\n"
+    "stp x21, x22, [x0, #16]\n"
+    "stp x23, x24, [x0, #32]\n"
+    "stp x25, x26, [x0, #48]\n"
+    "stp x27, x28, [x0, #64]\n"
+    // The frame pointer, and the link register which is the resume address
+    "stp x29, x30, [x0, #80]\n"
+    "mov x16, sp\n"
+    "str x16, [x0, #96]\n"
+    "stp d8, d9, [x0, #104]\n"
+    "stp d10, d11, [x0, #120]\n"
+    "stp d12, d13, [x0, #136]\n"
+    "stp d14, d15, [x0, #152]\n"
+    "mov w0, #0\n"
+    "ret\n"
+    EXCEPT_ASM_END(exC_fast_setjmp)
+    EXCEPT_ASM_FUNCTION(exC_fast_longjmp)
+    EXCEPT_ASM_ENTRY
+    "ldp x19, x20, [x0, #0]\n"
+    "ldp x21, x22, [x0, #16]\n"
+    "ldp x23, x24, [x0, #32]\n"
+    "ldp x25, x26, [x0, #48]\n"
+    "ldp x27, x28, [x0, #64]\n"
+    "ldp x29, x30, [x0, #80]\n"
+    "ldr x16, [x0, #96]\n"
+    "mov sp, x16\n"
+    "ldp d8, d9, [x0, #104]\n"
+    "ldp d10, d11, [x0, #120]\n"
+    "ldp d12, d13, [x0, #136]\n"
+    "ldp d14, d15, [x0, #152]\n"
+    "mov w0, #1\n"
+    // A return, which branch target identification does not check
+    "ret\n"
+    EXCEPT_ASM_END(exC_fast_longjmp)
+);
+#endif
+#endif
+
+// Resumes the block found by `exC_handler_env`, which reads `except` back from the context (see `EXCEPT_DISPATCH`)
+static EXCEPT_NORETURN void exC_jump(exC_context_t* ctx, exC_jmp_buf* env, EXCEPT_EXCEPTION_TYPE except)
+{
+    if (except == 0 || except == EXCEPT_UNWINDING)
+    {
+        // The block would run its `TRY` clause again, or skip its `CATCH` clauses
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception %s has been thrown.\n", except == 0 ? "0" : "EXCEPT_UNWINDING");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+    ctx->last_exception = except;
+    if (exC_block_state(ctx, ctx->top - 1) == BLOCK_UNWINDING)
+    {
+        exC_save_unwinding(ctx);
+        ctx->last_exception = EXCEPT_UNWINDING;
+    }
+    EXCEPT_LONGJMP(*env);
+}
+
+EXCEPT_API
+void exC_pop_stack(void)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL || ctx->top == 0)
+        return;
+    --ctx->top;
+    if (ctx->records != NULL && exC_release_records(ctx, ctx->top, RELEASE_POP))
+    {
+        // The block was unwinding : the exception goes on
+        exC_jmp_buf* env = exC_handler_env(ctx, true, ctx->last_exception);
+        exC_jump(ctx, env, ctx->last_exception);
+    }
+}
+
+EXCEPT_API
+int exC_enter_finally(void)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx != NULL && ctx->top != 0)
+        exC_set_block_state(ctx, ctx->top - 1, BLOCK_FINALLY);
+    return 0;
+}
+
+EXCEPT_API
+void exC_on_unwind(void (*fn)(void*), void* arg)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL || ctx->top == 0)
+    {
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " ON_UNWIND used outside of a TRY block.\n");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+    struct exC_record* record = exC_push_record(ctx, RECORD_CLEANUP, sizeof(struct exC_cleanup));
+    if (record == NULL)
+    {
+        // The cleanup still runs exactly once
+        fn(arg);
+        exC_unwind_static(EXCEPT_STACK_OVERFLOW, "Exception arena overflow");
+    }
+    *(struct exC_cleanup*) EXCEPT_RECORD_DATA(record) = (struct exC_cleanup) { .fn = fn, .arg = arg };
+}
+
+EXCEPT_API
+void* exC_frame_alloc(size_t size)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL || ctx->top == 0)
+        return NULL;
+    struct exC_record* record = exC_push_record(ctx, RECORD_MEMORY, size);
+    if (record != NULL)
+        return EXCEPT_RECORD_DATA(record);
+    // Too large for what is left of the arena : the block frees it when it ends
+    record = exC_push_record(ctx, RECORD_CLEANUP, sizeof(struct exC_cleanup));
+    if (record == NULL)
+        return NULL;
+    void* memory = malloc(size);
+    if (memory == NULL)
+    {
+        ctx->records = record->prev;
+        return NULL;
+    }
+    *(struct exC_cleanup*) EXCEPT_RECORD_DATA(record) = (struct exC_cleanup) { .fn = free, .arg = memory };
+    return memory;
+}
+
+// Ends a callback of `exC_run_batch` : what it left in the block (payloads, frame allocations, cleanups) is released
+static inline void exC_batch_next(exC_context_t* ctx, size_t depth)
+{
+    if (ctx->records != NULL)
+        exC_release_records(ctx, depth - 1, RELEASE_DROP);
+    exC_set_block_state(ctx, depth - 1, BLOCK_TRYING);
+}
+
+EXCEPT_API
+size_t exC_run_batch(const exC_callback_t* callbacks, size_t count)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL)
+    {
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " exC_run_batch called before exC_thrd_setup.\n");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+    // A single block for the whole batch : a callback that throws resumes it, instead of each callback setting up its own
+    exC_jmp_buf env;
+    exC_push_stack(&env);
+    size_t depth = ctx->top;
+    volatile size_t next = 0;
+    volatile size_t failed = 0;
+    if (EXCEPT_SETJMP(env) != 0)
+    {
+        // The error handler threw : the exception goes on to the enclosing block
+        if (ctx->last_exception == EXCEPT_UNWINDING)
+            exC_pop_stack();
+        const exC_callback_t* callback = &callbacks[next];
+        EXCEPT_MONITOR_EVENT(ctx, EVENT_CATCH, ctx->last_exception);
+        failed++;
+        if (callback->on_error != NULL)
+            callback->on_error(callback->arg, ctx->last_exception);
+        next++;
+        exC_batch_next(ctx, depth);
+    }
+    while (next < count)
+    {
+        const exC_callback_t* callback = &callbacks[next];
+        callback->fn(callback->arg);
+        next++;
+        exC_batch_next(ctx, depth);
+    }
+    exC_pop_stack();
+    return failed;
+}
+
+EXCEPT_API
+exC_result_t exC_call_result(void (*fn)(void*), void* arg)
+{
+    // Callers from outside may not have set their thread up
+    if (EXCEPT_CONTEXT() == NULL && exC_thrd_setup() != 0)
+    {
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " exC_call_result could not set up the exception context.\n");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+    exC_jmp_buf env;
+    exC_push_stack(&env);
+    exC_result_t result = { .code = 0, .what = NULL };
+    if (EXCEPT_SETJMP(env) == 0)
+        fn(arg);
+    else
+    {
+        // The context is looked up again, nothing from before `setjmp` being kept
+        exC_on_catch();
+        result.code = exC_last_exception();
+        result.what = exC_last_exception_what();
+    }
+    exC_pop_stack();
+    return result;
+}
+
+// Copies `what` in the thread's `WHAT` buffer, truncated to `EXCEPT_WHAT_MAX_SIZE - 1` characters
+static void exC_copy_what(exC_context_t* ctx, const char* what)
+{
+    // Only copy what is needed (the message may be a temporary buffer of the throwing function)
+    char* buffer = EXCEPT_THRD_DATA(ctx)->what_buffer;
+    const char* end = memchr(what, '\0', EXCEPT_WHAT_MAX_SIZE - 1);
+    size_t length = end != NULL ? (size_t) (end - what) : EXCEPT_WHAT_MAX_SIZE - 1;
+    memmove(buffer, what, length);
+    buffer[length] = '\0';
+    ctx->what = buffer;
+}
+
+EXCEPT_API EXCEPT_NORETURN EXCEPT_SENTINEL_NULL(0)
+void exC_unwind(EXCEPT_EXCEPTION_TYPE except, ...)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_CAPTURE_TRACE(ctx);
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_THROW, except);
+    va_list args;
+    va_start(args, except);
+    const char* what = va_arg(args, const char*);
+    va_end(args);
+    // The message may be in memory released by `exC_handler_env` (see `exC_frame_alloc`), so it is copied first
+    if (ctx != NULL)
+    {
+        if (what != NULL)
+            exC_copy_what(ctx, what);
+        else
+            ctx->what = "";
+    }
+    exC_jmp_buf* env = exC_handler_env(ctx, false, except);
+    ctx->payload = NULL;
+    EXCEPT_FLIGHT_WHAT(ctx);
+    exC_jump(ctx, env, except);
+}
+
+EXCEPT_API EXCEPT_NORETURN
+void exC_unwind_static(EXCEPT_EXCEPTION_TYPE except, const char* what)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_CAPTURE_TRACE(ctx);
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_THROW, except);
+    exC_jmp_buf* env = exC_handler_env(ctx, false, except);
+    ctx->what = what != NULL ? what : "";
+    ctx->payload = NULL;
+    EXCEPT_FLIGHT_WHAT(ctx);
+    exC_jump(ctx, env, except);
+}
+
+/*
+ * Parses the conversion specification starting right after a '%'. Returns a pointer to its last character (the
+ * conversion specifier), and stores the length modifier in `length` ('H' for "hh", 'L' for "ll" and "L").
+ */
+static const char* exC_fmt_parse_spec(const char* spec, char* length, size_t* stars)
+{
+    *stars = 0;
+    while (*spec != '\0' && strchr("-+ #0", *spec) != NULL)
+        ++spec;
+    for (int part = 0; part < 2; ++part)
+    {
+        if (part == 1)
+        {
+            if (*spec != '.')
+                break;
+            ++spec;
+        }
+        if (*spec == '*')
+        {
+            ++*stars;
+            ++spec;
+        }
+        else
+        {
+            while (*spec >= '0' && *spec <= '9')
+                ++spec;
+        }
+    }
+    *length = '\0';
+    switch (*spec)
+    {
+        case 'h': case 'l':
+            *length = spec[1] == spec[0] ? (char) (spec[0] == 'h' ? 'H' : 'L') : spec[0];
+            spec += spec[1] == spec[0] ? 2 : 1;
+            break;
+        case 'j': case 'z': case 't': case 'L':
+            *length = *spec++;
+            break;
+        default:
+            break;
+    }
+    return spec;
+}
+
+// Captures the arguments of `fmt`. Returns false if they can not all be captured.
+static bool exC_fmt_capture(struct exC_what_fmt* what_fmt, const char* fmt, va_list args)
+{
+    size_t argc = 0;
+    size_t strings_used = 0;
+    for (const char* c = strchr(fmt, '%'); c != NULL; c = strchr(c + 1, '%'))
+    {
+        char length;
+        size_t stars;
+        c = exC_fmt_parse_spec(c + 1, &length, &stars);
+        if (*c == '%')
+            continue;
+        if (argc + stars + 1 > EXCEPT_WHAT_FMT_MAX_ARGS)
+            return false;
+        while (stars-- != 0)
+        {
+            what_fmt->args[argc].kind = FMT_ARG_INT;
+            what_fmt->args[argc++].value.i = va_arg(args, int);
+        }
+        struct exC_fmt_arg* arg = &what_fmt->args[argc++];
+        switch (*c)
+        {
+            case 'c':
+                if (length != '\0')
+                    return false;
+                arg->kind = FMT_ARG_INT;
+                arg->value.i = va_arg(args, int);
+                break;
+            case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+                switch (length)
+                {
+                    case 'l': arg->kind = FMT_ARG_LONG; arg->value.i = va_arg(args, long); break;
+                    case 'L': arg->kind = FMT_ARG_LLONG; arg->value.i = va_arg(args, long long); break;
+                    case 'j': arg->kind = FMT_ARG_INTMAX; arg->value.imax = va_arg(args, intmax_t); break;
+                    case 'z': arg->kind = FMT_ARG_SIZE; arg->value.i = (long long) va_arg(args, size_t); break;
+                    case 't': arg->kind = FMT_ARG_PTRDIFF; arg->value.i = va_arg(args, ptrdiff_t); break;
+                    default: arg->kind = FMT_ARG_INT; arg->value.i = va_arg(args, int); break;
+                }
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                if (length == 'L')
+                {
+                    arg->kind = FMT_ARG_LDOUBLE;
+                    arg->value.ld = va_arg(args, long double);
+                }
+                else
+                {
+                    arg->kind = FMT_ARG_DOUBLE;
+                    arg->value.d = va_arg(args, double);
+                }
+                break;
+            case 'p':
+                arg->kind = FMT_ARG_PTR;
+                arg->value.p = va_arg(args, const void*);
+                break;
+            case 's':
+            {
+                if (length != '\0')
+                    return false;
+                // The string may be a temporary buffer of the throwing function
+                const char* str = va_arg(args, const char*);
+                char* copy = what_fmt->strings + strings_used;
+                size_t left = EXCEPT_WHAT_FMT_STRINGS_SIZE - strings_used;
+                if (str == NULL)
+                    str = "(null)";
+                const char* end = memchr(str, '\0', left - 1);
+                size_t size = end != NULL ? (size_t) (end - str) : left - 1;
+                memcpy(copy, str, size);
+                copy[size] = '\0';
+                strings_used += size + 1;
+                arg->kind = FMT_ARG_STR;
+                arg->value.s = copy;
+                break;
+            }
+            default:
+                // `%n` and unknown conversions
+                return false;
+        }
+        if (strings_used >= EXCEPT_WHAT_FMT_STRINGS_SIZE)
+            strings_used = EXCEPT_WHAT_FMT_STRINGS_SIZE - 1;
+    }
+    what_fmt->argc = argc;
+    return true;
+}
+
+// Formats the captured arguments into `buffer`, one conversion specification at a time
+static void exC_fmt_render(const struct exC_what_fmt* what_fmt, char* buffer, size_t size)
+{
+    const char* fmt = what_fmt->fmt;
+    const struct exC_fmt_arg* arg = what_fmt->args;
+    size_t used = 0;
+    while (*fmt != '\0' && used < size - 1)
+    {
+        const char* c = strchr(fmt, '%');
+        size_t literal = c != NULL ? (size_t) (c - fmt) : strlen(fmt);
+        if (literal > size - 1 - used)
+            literal = size - 1 - used;
+        memcpy(buffer + used, fmt, literal);
+        used += literal;
+        if (c == NULL || used >= size - 1)
+            break;
+
+        // Rebuild the specification, with `*` replaced by the captured values
+        char spec[64] = "%";
+        size_t spec_len = 1;
+        char length;
+        size_t stars;
+        const char* end = exC_fmt_parse_spec(c + 1, &length, &stars);
+        fmt = end + (*end != '\0');
+        for (const char* s = c + 1; s < fmt && spec_len < sizeof(spec) - 24; ++s)
+        {
+            if (*s == '*')
+                spec_len += (size_t) snprintf(spec + spec_len, sizeof(spec) - spec_len, "%d", (int) (arg++)->value.i);
+            else
+                spec[spec_len++] = *s;
+        }
+        spec[spec_len] = '\0';
+
+        char* out = buffer + used;
+        size_t left = size - used;
+        int written;
+        if (*end == '%')
+            written = snprintf(out, left, "%%");
+        else if (*end == '\0')
+            break;
+        else
+        {
+            bool is_unsigned = strchr("ouxX", *end) != NULL;
+            switch (arg->kind)
+            {
+                case FMT_ARG_INT:
+                    written = is_unsigned ? snprintf(out, left, spec, (unsigned int) arg->value.i)
+                                          : snprintf(out, left, spec, (int) arg->value.i);
+                    break;
+                case FMT_ARG_LONG:
+                    written = is_unsigned ? snprintf(out, left, spec, (unsigned long) arg->value.i)
+                                          : snprintf(out, left, spec, (long) arg->value.i);
+                    break;
+                case FMT_ARG_LLONG:
+                    written = is_unsigned ? snprintf(out, left, spec, (unsigned long long) arg->value.i)
+                                          : snprintf(out, left, spec, arg->value.i);
+                    break;
+                case FMT_ARG_INTMAX:
+                    written = is_unsigned ? snprintf(out, left, spec, (uintmax_t) arg->value.imax)
+                                          : snprintf(out, left, spec, arg->value.imax);
+                    break;
+                case FMT_ARG_SIZE:
+                    written = snprintf(out, left, spec, (size_t) arg->value.i);
+                    break;
+                case FMT_ARG_PTRDIFF:
+                    written = snprintf(out, left, spec, (ptrdiff_t) arg->value.i);
+                    break;
+                case FMT_ARG_DOUBLE:
+                    written = snprintf(out, left, spec, arg->value.d);
+                    break;
+                case FMT_ARG_LDOUBLE:
+                    written = snprintf(out, left, spec, arg->value.ld);
+                    break;
+                case FMT_ARG_PTR:
+                    written = snprintf(out, left, spec, arg->value.p);
+                    break;
+                case FMT_ARG_STR:
+                default:
+                    written = snprintf(out, left, spec, arg->value.s);
+                    break;
+            }
+            ++arg;
+        }
+        if (written < 0)
+            break;
+        used += (size_t) written < left ? (size_t) written : left - 1;
+    }
+    buffer[used] = '\0';
+}
+
+EXCEPT_API EXCEPT_NORETURN
+void exC_unwind_fmt(EXCEPT_EXCEPTION_TYPE except, int fmt_is_static, const char* fmt, ...)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_CAPTURE_TRACE(ctx);
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_THROW, except);
+    // The arguments may be in memory released by `exC_handler_env` (see `exC_frame_alloc`), so they are captured first
+    if (ctx != NULL)
+    {
+        struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+        va_list args;
+        va_start(args, fmt);
+        va_list args_copy;
+        va_copy(args_copy, args);
+        if (fmt == NULL)
+            ctx->what = "";
+        else if (fmt_is_static && exC_fmt_capture(&data->what_fmt, fmt, args))
+        {
+            // Formatting is deferred to `exC_last_exception_what`
+            data->what_fmt.fmt = fmt;
+            ctx->what = NULL;
+        }
+        else
+        {
+            // The format itself could be a temporary, or the arguments could not be captured
+            vsnprintf(data->what_buffer, EXCEPT_WHAT_MAX_SIZE, fmt, args_copy);
+            ctx->what = data->what_buffer;
+        }
+        va_end(args_copy);
+        va_end(args);
+    }
+    exC_jmp_buf* env = exC_handler_env(ctx, false, except);
+    ctx->payload = NULL;
+    EXCEPT_FLIGHT_WHAT(ctx);
+    exC_jump(ctx, env, except);
+}
+
+// Throws `except` with a copy of `payload`, and `what` as its message (which must outlive the exception)
+static EXCEPT_NORETURN void exC_throw_payload(EXCEPT_EXCEPTION_TYPE except, const char* what, const void* payload, size_t size)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_CAPTURE_TRACE(ctx);
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_THROW, except);
+    exC_jmp_buf* env = exC_handler_env(ctx, false, except);
+    struct exC_record* record = exC_push_record(ctx, RECORD_PAYLOAD, size);
+    // If the arena is full, the exception is thrown without its payload
+    if (record != NULL)
+        memcpy(EXCEPT_RECORD_DATA(record), payload, size);
+    ctx->payload = record;
+    ctx->what = what;
+    EXCEPT_FLIGHT_WHAT(ctx);
+    exC_jump(ctx, env, except);
+}
+
+EXCEPT_API EXCEPT_NORETURN
+void exC_unwind_payload(EXCEPT_EXCEPTION_TYPE except, const void* payload, size_t size)
+{
+    exC_throw_payload(except, "", payload, size);
+}
+
+EXCEPT_API EXCEPT_NORETURN
+void exC_rethrow(void)
+{
+    // Exception and message are still stored, so there is nothing to copy
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_RETHROW, ctx != NULL ? ctx->last_exception : 0);
+    exC_jmp_buf* env = exC_handler_env(ctx, true, ctx != NULL ? ctx->last_exception : 0);
+    exC_jump(ctx, env, ctx->last_exception);
+}
+
+EXCEPT_API
+exC_captured_t* exC_capture_current(void)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL || ctx->last_exception == 0 || ctx->last_exception == EXCEPT_UNWINDING)
+        return NULL;
+    const char* what = exC_last_exception_what();
+    size_t what_size = strlen(what) + 1;
+    struct exC_record* payload = ctx->payload;
+    size_t payload_size = payload != NULL ? payload->size : 0;
+    exC_captured_t* captured = malloc(sizeof(exC_captured_t) + payload_size + what_size);
+    if (captured == NULL)
+        return NULL;
+    captured->except = ctx->last_exception;
+    captured->has_payload = payload != NULL;
+    captured->payload_size = payload_size;
+    if (payload != NULL)
+        memcpy(captured->data, EXCEPT_RECORD_DATA(payload), payload_size);
+    char* what_copy = (char*) captured->data + payload_size;
+    memcpy(what_copy, what, what_size);
+    captured->what = what_copy;
+#if defined(EXCEPT_CAPTURE_STACK_TRACE)
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    memcpy(captured->trace, data->trace, data->trace_size * sizeof(void*));
+    captured->trace_size = data->trace_size;
+#endif
+    return captured;
+}
 
-static inline void exC_set_stack_size(size_t size);
-static inline int exC_create_stack(void);
+EXCEPT_API EXCEPT_NORETURN
+void exC_rethrow_captured(exC_captured_t* captured)
+{
+    if (captured == NULL)
+    {
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " No captured exception to rethrow.\n");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+    // Thrown anew in this thread, with the message, payload and stack trace of the original throw
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_THROW, captured->except);
+    exC_jmp_buf* env = exC_handler_env(ctx, false, captured->except);
+    // Messages stored by address may be longer than the `WHAT` buffer
+    exC_copy_what(ctx, captured->what);
+    ctx->payload = NULL;
+    if (captured->has_payload)
+    {
+        struct exC_record* record = exC_push_record(ctx, RECORD_PAYLOAD, captured->payload_size);
+        // If the arena is full, the exception is thrown without its payload
+        if (record != NULL)
+            memcpy(EXCEPT_RECORD_DATA(record), captured->data, captured->payload_size);
+        ctx->payload = record;
+    }
+#if defined(EXCEPT_CAPTURE_STACK_TRACE)
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    memcpy(data->trace, captured->trace, captured->trace_size * sizeof(void*));
+    data->trace_size = captured->trace_size;
+#endif
+    EXCEPT_EXCEPTION_TYPE except = captured->except;
+    free(captured);
+    EXCEPT_FLIGHT_WHAT(ctx);
+    exC_jump(ctx, env, except);
+}
 
-static void stack_tss_create(void);
-static void last_exception_what_tss_create(void);
+EXCEPT_API
+EXCEPT_EXCEPTION_TYPE exC_captured_exception(const exC_captured_t* captured)
+{
+    return captured != NULL ? captured->except : 0;
+}
 
 EXCEPT_API
-int exC_is_global_setup_done(void)
+const char* exC_captured_what(const exC_captured_t* captured)
 {
-    return global_setup_done && stack_size_set ? 1 : 0;
+    return captured != NULL ? captured->what : "";
 }
 
 EXCEPT_API
-int exC_is_thread_setup_done(void)
+void exC_captured_free(exC_captured_t* captured)
 {
-    return thread_setup_done && stack_created ? 1 : 0;
+    free(captured);
 }
 
 EXCEPT_API
-int exC_global_setup(size_t stack_size, exC_flags_t flags)
+const char* exC_last_exception_what(void)
 {
-    if (global_setup_done)
-        return 0;
-    user_flags = flags;
-    exC_set_stack_size(stack_size);
-    global_setup_done = true;
-    return 0;
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL)
+        return "";
+    if (ctx->what == NULL)
+    {
+        // First read of a `THROWF` message
+        struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+        exC_fmt_render(&data->what_fmt, data->what_buffer, EXCEPT_WHAT_MAX_SIZE);
+        ctx->what = data->what_buffer;
+    }
+    return ctx->what;
 }
 
 EXCEPT_API
-int exC_thrd_setup(void)
+EXCEPT_EXCEPTION_TYPE exC_last_exception(void)
 {
-    if (!global_setup_done)
-        return -1;
-    if (thread_setup_done)
-        return 0;
-    CALL_ONCE(&stack_once, stack_tss_create);
-    CALL_ONCE(&last_exception_what_once, last_exception_what_tss_create);
-    if (exC_create_stack() != 0)
-        return -1;
-    thread_setup_done = true;
-    return 0;
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    return ctx != NULL ? ctx->last_exception : 0;
 }
 
-static inline void exC_set_stack_size(size_t size)
+EXCEPT_API
+const void* exC_last_payload(size_t size)
 {
-    if (stack_size_set)
-        return;
-    stack_size = size;
-    stack_size_set = true;
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL || ctx->payload == NULL)
+        return NULL;
+    struct exC_record* record = ctx->payload;
+    return record->size == size ? EXCEPT_RECORD_DATA(record) : NULL;
 }
 
 EXCEPT_API
-int exC_is_stack_size_set(void)
+void exC_throw_site(const char* file, int line)
 {
-    return stack_size_set ? 1 : 0;
+#if defined(EXCEPT_STATS)
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    struct exC_monitor* monitor = ctx != NULL ? EXCEPT_THRD_DATA(ctx)->monitor : NULL;
+    if (monitor != NULL)
+    {
+        monitor->site_file = file;
+        monitor->site_line = line;
+    }
+#else
+    (void)file;
+    (void)line;
+#endif
 }
 
 EXCEPT_API
-int exC_is_stack_created(void)
+void exC_on_catch(void)
 {
-    return stack_created ? 1 : 0;
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    EXCEPT_MONITOR_EVENT(ctx, EVENT_CATCH, ctx != NULL ? ctx->last_exception : 0);
 }
 
-static inline int exC_create_stack(void)
+#if defined(EXCEPT_STATS)
+static int exC_compare_codes(const void* a, const void* b)
 {
-    if (stack_created)
-        return 0;
-    if (!stack_size_set)
-        return -1;
-    if (TSS_SET(stack, calloc(stack_size, sizeof(jmp_buf*))) != THRD_SUCCESS)
-        return -1;
-    if (TSS_SET(last_exception_what, calloc(EXCEPT_WHAT_MAX_SIZE, sizeof(char))) != THRD_SUCCESS)
+    unsigned long long thrown_a = ((const exC_code_stats_t*) a)->thrown;
+    unsigned long long thrown_b = ((const exC_code_stats_t*) b)->thrown;
+    return (thrown_a < thrown_b) - (thrown_a > thrown_b);
+}
+
+static int exC_compare_sites(const void* a, const void* b)
+{
+    unsigned long long thrown_a = ((const exC_site_stats_t*) a)->thrown;
+    unsigned long long thrown_b = ((const exC_site_stats_t*) b)->thrown;
+    return (thrown_a < thrown_b) - (thrown_a > thrown_b);
+}
+
+// Adds the counters of one thread to `stats`, and its sites to `sites`
+static void exC_stats_merge(struct exC_monitor* monitor, exC_stats_t* stats, exC_site_stats_t* sites, size_t* site_count)
+{
+    stats->untracked += atomic_load_explicit(&monitor->untracked, memory_order_relaxed);
+    for (size_t i = 0; i < EXCEPT_STATS_CODES; ++i)
     {
-        TSS_DELETE(stack);
-        return -1;
+        struct exC_code_counters* counters = &monitor->codes[i];
+        EXCEPT_EXCEPTION_TYPE code = atomic_load_explicit(&counters->code, memory_order_acquire);
+        if (code == 0)
+            continue;
+        unsigned long long counts[EVENT_COUNT];
+        for (size_t event = 0; event < EVENT_COUNT; ++event)
+            counts[event] = atomic_load_explicit(&counters->counts[event], memory_order_relaxed);
+        size_t j = 0;
+        while (j < stats->code_count && stats->codes[j].code != code)
+            ++j;
+        if (j == EXCEPT_STATS_CODES)
+        {
+            // Other threads filled the table with other codes
+            for (size_t event = 0; event < EVENT_COUNT; ++event)
+                stats->untracked += counts[event];
+            continue;
+        }
+        if (j == stats->code_count)
+            stats->codes[stats->code_count++].code = code;
+        stats->codes[j].thrown += counts[EVENT_THROW];
+        stats->codes[j].caught += counts[EVENT_CATCH];
+        stats->codes[j].rethrown += counts[EVENT_RETHROW];
+        stats->codes[j].terminated += counts[EVENT_TERMINATE];
     }
-    if (TSS_GET(stack) == NULL || TSS_GET(last_exception_what) == NULL)
+    for (size_t i = 0; i < EXCEPT_STATS_SITES; ++i)
     {
-        if (TSS_GET(stack) != NULL)
-            TSS_DELETE(stack);
-        if (TSS_GET(last_exception_what) != NULL)
-            TSS_DELETE(last_exception_what);
-        return -1;
+        struct exC_site_counters* counters = &monitor->sites[i];
+        const char* file = atomic_load_explicit(&counters->file, memory_order_acquire);
+        if (file == NULL)
+            continue;
+        // The same file may have several `__FILE__` strings, one per translation unit
+        size_t j = 0;
+        while (j < *site_count && (sites[j].line != counters->line || strcmp(sites[j].file, file) != 0))
+            ++j;
+        if (j == *site_count)
+        {
+            sites[j] = (exC_site_stats_t) { .file = file, .line = counters->line, .code = counters->code };
+            ++*site_count;
+        }
+        sites[j].thrown += atomic_load_explicit(&counters->thrown, memory_order_relaxed);
     }
-    stack_created = true;
-    stack_top = 0;
-    return 0;
 }
+#endif
 
 EXCEPT_API
-int exC_push_stack(jmp_buf* env)
+int exC_stats_snapshot(exC_stats_t* stats)
 {
-    if (!stack_created)
+#if defined(EXCEPT_STATS)
+    if (stats == NULL)
         return -1;
-    if (stack_top >= stack_size) 
-    {
-        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception stack overflow.\n");
-        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
-    }
-    jmp_buf** stack_ptr = TSS_GET(stack);
-    if (stack_ptr == NULL)
+    memset(stats, 0, sizeof(*stats));
+    // Monitors are only added in front of the list, so the ones after `first` do not change
+    struct exC_monitor* first = atomic_load_explicit(&exC_monitors, memory_order_acquire);
+    size_t site_capacity = 0;
+    for (struct exC_monitor* monitor = first; monitor != NULL; monitor = monitor->next)
+        site_capacity += EXCEPT_STATS_SITES;
+    exC_site_stats_t* sites = malloc((site_capacity != 0 ? site_capacity : 1) * sizeof(exC_site_stats_t));
+    if (sites == NULL)
         return -1;
-    stack_ptr[stack_top++] = env;
+    size_t site_count = 0;
+    for (struct exC_monitor* monitor = first; monitor != NULL; monitor = monitor->next)
+        exC_stats_merge(monitor, stats, sites, &site_count);
+    qsort(stats->codes, stats->code_count, sizeof(exC_code_stats_t), exC_compare_codes);
+    qsort(sites, site_count, sizeof(exC_site_stats_t), exC_compare_sites);
+    stats->site_count = site_count < EXCEPT_STATS_TOP_SITES ? site_count : EXCEPT_STATS_TOP_SITES;
+    memcpy(stats->top_sites, sites, stats->site_count * sizeof(exC_site_stats_t));
+    free(sites);
     return 0;
+#else
+    (void)stats;
+    return -1;
+#endif
 }
 
 EXCEPT_API
-void exC_pop_stack(void)
+int exC_sample_every(unsigned long throws)
 {
-    if (!stack_created || stack_top == 0)
-        return;
-    jmp_buf** stack_ptr = TSS_GET(stack);
-    if (stack_ptr == NULL)
+#if defined(EXCEPT_SAMPLING)
+    atomic_store_explicit(&exC_sample_period, throws, memory_order_relaxed);
+    atomic_store_explicit(&exC_sample_interval, 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&exC_sample_generation, 1, memory_order_release);
+    return 0;
+#else
+    (void)throws;
+    return -1;
+#endif
+}
+
+EXCEPT_API
+int exC_sample_rate(double per_second)
+{
+#if defined(EXCEPT_SAMPLING)
+    // 0 turns sampling off. From one sample every 31 years to one every nanosecond.
+    if (!(per_second == 0 || (per_second >= 1e-9 && per_second <= 1e9)))
+        return -1;
+    atomic_store_explicit(&exC_sample_period, 0, memory_order_relaxed);
+    atomic_store_explicit(&exC_sample_interval, per_second != 0 ? (unsigned long long) (1e9 / per_second) : 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&exC_sample_generation, 1, memory_order_release);
+    return 0;
+#else
+    (void)per_second;
+    return -1;
+#endif
+}
+
+EXCEPT_API
+size_t exC_samples_drain(exC_sample_t* samples, size_t max)
+{
+    size_t count = 0;
+#if defined(EXCEPT_SAMPLING)
+    for (struct exC_monitor* monitor = atomic_load_explicit(&exC_monitors, memory_order_acquire); monitor != NULL && count < max;
+         monitor = monitor->next)
     {
-        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Failed to pop exception stack.\n");
-        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        // Another thread is draining this one
+        if (atomic_exchange_explicit(&monitor->draining, true, memory_order_acquire))
+            continue;
+        size_t tail = atomic_load_explicit(&monitor->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&monitor->head, memory_order_acquire);
+        for (; tail != head && count < max; ++tail)
+            samples[count++] = monitor->samples[tail % EXCEPT_SAMPLE_RING];
+        atomic_store_explicit(&monitor->tail, tail, memory_order_release);
+        atomic_store_explicit(&monitor->draining, false, memory_order_release);
     }
-    stack_ptr[--stack_top] = NULL;
+#else
+    (void)samples;
+    (void)max;
+#endif
+    return count;
 }
 
-EXCEPT_API EXCEPT_NORETURN EXCEPT_SENTINEL_NULL(0)
-void exC_unwind(EXCEPT_EXCEPTION_TYPE except, ...)
+#if defined(EXCEPT_SAMPLING)
+// Orders samples by code, then stack, so that identical ones are next to each other
+static int exC_compare_samples(const void* a, const void* b)
+{
+    const exC_sample_t* sample_a = a;
+    const exC_sample_t* sample_b = b;
+    if (sample_a->code != sample_b->code)
+        return sample_a->code < sample_b->code ? -1 : 1;
+    if (sample_a->depth != sample_b->depth)
+        return sample_a->depth < sample_b->depth ? -1 : 1;
+    return memcmp(sample_a->frames, sample_b->frames, sample_a->depth * sizeof(void*));
+}
+
+#if defined(EXCEPT_HAS_DLADDR)
+// Spaces and semicolons separate the count and the frames of a collapsed stack
+static void exC_write_frame_name(FILE* stream, const char* name)
+{
+    for (; *name != '\0'; ++name)
+        fputc(*name == ' ' || *name == ';' ? '_' : *name, stream);
+}
+#endif
+
+static void exC_write_frame(FILE* stream, void* address)
 {
-    if (!stack_created || stack_top == 0)
+#if defined(EXCEPT_HAS_DLADDR)
+    Dl_info info;
+    // A return address is after its call, which may be the last instruction of its function (calls to `noreturn`
+    // functions, like `exC_unwind`)
+    if (dladdr((char*) address - 1, &info) != 0 && info.dli_fname != NULL)
     {
-        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Exception has been thrown without initializing the exception stack.\n");
-        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        if (info.dli_sname != NULL)
+        {
+            exC_write_frame_name(stream, info.dli_sname);
+            return;
+        }
+        const char* module = strrchr(info.dli_fname, '/');
+        exC_write_frame_name(stream, module != NULL ? module + 1 : info.dli_fname);
+        fprintf(stream, "+0x%tx", (char*) address - (char*) info.dli_fbase);
+        return;
     }
-    last_exception = except;
-    va_list args;
-    va_start(args, except);
-    char* what = va_arg(args, char*);
-    va_end(args);
-    char* last_exception_what_ptr = TSS_GET(last_exception_what);
-    if (what != NULL)
+#endif
+    fprintf(stream, "%p", address);
+}
+#endif
+
+EXCEPT_API
+int exC_samples_write_collapsed(FILE* stream)
+{
+#if defined(EXCEPT_SAMPLING)
+    if (stream == NULL)
+        return -1;
+    size_t capacity = 0;
+    for (struct exC_monitor* monitor = atomic_load_explicit(&exC_monitors, memory_order_acquire); monitor != NULL; monitor = monitor->next)
+        capacity += EXCEPT_SAMPLE_RING;
+    exC_sample_t* samples = malloc((capacity != 0 ? capacity : 1) * sizeof(exC_sample_t));
+    if (samples == NULL)
+        return -1;
+    size_t count = exC_samples_drain(samples, capacity);
+    qsort(samples, count, sizeof(exC_sample_t), exC_compare_samples);
+    for (size_t i = 0, next; i < count; i = next)
     {
-        strncpy(last_exception_what_ptr, what, EXCEPT_WHAT_MAX_SIZE - 1);
-        last_exception_what_ptr[EXCEPT_WHAT_MAX_SIZE - 1] = '\0';
+        for (next = i + 1; next < count && exC_compare_samples(&samples[i], &samples[next]) == 0; ++next)
+            ;
+        // Outermost frame first, and the exception as the leaf
+        for (size_t frame = samples[i].depth; frame > 0; --frame)
+        {
+            exC_write_frame(stream, samples[i].frames[frame - 1]);
+            fputc(';', stream);
+        }
+        fprintf(stream, "exception:%ju %zu\n", (uintmax_t) samples[i].code, next - i);
     }
-    else
-        last_exception_what_ptr[0] = '\0';
-    jmp_buf** stack_ptr = TSS_GET(stack);
-    if (stack_ptr == NULL)
+    free(samples);
+    return 0;
+#else
+    (void)stream;
+    return -1;
+#endif
+}
+
+EXCEPT_API
+size_t exC_stack_trace(void* const** frames)
+{
+#if defined(EXCEPT_CAPTURE_STACK_TRACE)
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx != NULL)
     {
-        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Failed to unwind exception stack.\n");
-        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        *frames = EXCEPT_THRD_DATA(ctx)->trace;
+        return EXCEPT_THRD_DATA(ctx)->trace_size;
     }
-    longjmp(*stack_ptr[--stack_top], (int) except); // `except` must satisfy 0 < except <= 512
+#endif
+    *frames = NULL;
+    return 0;
 }
 
 EXCEPT_API
-char* exC_last_exception_what(void)
+void exC_print_stack_trace(FILE* stream)
 {
-    return TSS_GET(last_exception_what);
+    void* const* frames;
+    size_t size = exC_stack_trace(&frames);
+    for (size_t i = 0; i < size; i++)
+    {
+#if defined(EXCEPT_HAS_DLADDR)
+        Dl_info info;
+        if (dladdr(frames[i], &info) != 0 && info.dli_fname != NULL)
+        {
+            // The offset in the module is what `addr2line -e <module>` expects (for PIE executables and libraries)
+            fprintf(stream, "    #%zu %p", i, frames[i]);
+            // Only exported symbols are known (link executables with `-rdynamic`)
+            if (info.dli_sname != NULL)
+                fprintf(stream, " in %s+0x%tx", info.dli_sname, (char*) frames[i] - (char*) info.dli_saddr);
+            fprintf(stream, " (%s+0x%tx)\n", info.dli_fname, (char*) frames[i] - (char*) info.dli_fbase);
+            continue;
+        }
+#endif
+        fprintf(stream, "    #%zu %p\n", i, frames[i]);
+    }
 }
 
 EXCEPT_API
-EXCEPT_EXCEPTION_TYPE exC_last_exception(void)
+void exC_print_flight_recorder(FILE* stream)
 {
-    return last_exception;
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    static const char* const names[EVENT_COUNT] = { "throw", "catch", "rethrow", "terminate" };
+    for (struct exC_monitor* monitor = atomic_load_explicit(&exC_monitors, memory_order_acquire); monitor != NULL; monitor = monitor->next)
+    {
+        size_t next = atomic_load_explicit(&monitor->flight_next, memory_order_acquire);
+        if (next == 0)
+            continue;
+        fprintf(stream, P_BOLD "EXCEPT FLIGHT RECORDER:" P_RESET " thread %lu%s, oldest event first\n",
+                atomic_load_explicit(&monitor->thread, memory_order_relaxed),
+                atomic_load_explicit(&monitor->in_use, memory_order_relaxed) ? "" : " (ended)");
+        for (size_t i = next > EXCEPT_FLIGHT_EVENTS ? next - EXCEPT_FLIGHT_EVENTS : 0; i < next; ++i)
+        {
+            struct exC_flight_event* entry = &monitor->flight[i & (EXCEPT_FLIGHT_EVENTS - 1)];
+            int event = atomic_load_explicit(&entry->event, memory_order_relaxed);
+            const char* what = atomic_load_explicit(&entry->what, memory_order_relaxed);
+            // Only the address of the message is printed : it may have been overwritten, or freed, since
+            fprintf(stream, "    #%zu %s %ju", i, event >= 0 && event < EVENT_COUNT ? names[event] : "?",
+                    (uintmax_t) atomic_load_explicit(&entry->code, memory_order_relaxed));
+            if (what != NULL)
+                fprintf(stream, " what %p", (const void*) what);
+            fprintf(stream, " depth %zu time %llu\n", atomic_load_explicit(&entry->depth, memory_order_relaxed),
+                    atomic_load_explicit(&entry->time, memory_order_relaxed));
+        }
+    }
+#else
+    (void)stream;
+#endif
 }
 
 EXCEPT_API
@@ -313,14 +2493,16 @@ int exC_set_term_handler(term_handler_t handler)
 EXCEPT_API EXCEPT_NORETURN
 void exC_terminate(int status, ...)
 {
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    exC_print_flight_recorder(stderr);
+#endif
     if (term_handler == NULL)
         exit(status);
 
     // Because `exC_terminate` deletes those TSS keys, user should exit each thread before calling `exC_terminate`,
     // so the destructors are called and the memory is freed
     // (though it's not a big deal if they don't, since operating systems will clean up the memory anyway)    
-    TSS_DELETE(stack);
-    TSS_DELETE(last_exception_what);
+    TSS_DELETE(context);
 
 #if (EXCEPT_TERM_HANDLER_ARGC == 2)
         va_list args;
@@ -391,47 +2573,448 @@ void exC_terminate(int status, ...)
     exit(status);
 }
 
-static void stack_tss_free(void* ptr)
+static void context_tss_free(void* ptr)
+{
+    struct exC_thrd_data* data = ptr;
+    if (data == NULL)
+        return;
+    if (data->ctx.stack != data->initial_stack)
+        free(data->ctx.stack);
+#if defined(EXCEPT_MONITOR)
+    exC_monitor_release(data->monitor);
+#endif
+#if defined(EXCEPT_HAS_SIGNALS)
+    exC_signal_stack_free(data);
+#endif
+    EXCEPT_ALIGNED_FREE(data);
+}
+
+static void context_tss_create(void)
+{
+    if (TSS_CREATE(&context, context_tss_free) != THRD_SUCCESS)
+    {
+        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Failed to create exception context.\n");
+        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+    }
+}
+
+EXCEPT_API
+void exC_thrd_deinit(void)
 {
-    free(ptr);
-    ptr = NULL;
+    // Deallocate the context, i.e. the stack and the WHAT buffer (only for the current thread)
+    struct exC_thrd_data* data = TSS_GET(context);
+    if (data == NULL)
+        return;
+    TSS_SET(context, NULL);
+#if !defined(EXCEPT_USE_CUSTOM_THREADS) || defined(EXCEPT_ONE_THREAD)
+    exC_current_context = NULL;
+#endif
+    context_tss_free(data);
 }
 
-static void last_exception_what_tss_free(void* ptr)
+EXCEPT_API
+void exC_global_deinit(void)
 {
-    stack_tss_free(ptr);
+    // Deallocate the stack and the WHAT buffer (for all threads, i.e. deallocate thread-specific data)
+    TSS_DELETE(context);
+#if defined(EXCEPT_MONITOR)
+    exC_monitors_free();
+#endif
 }
 
-static void stack_tss_create(void)
+#if defined(EXCEPT_HAS_SIGNALS)
+static const int exC_fault_signals[] = { SIGSEGV, SIGFPE, SIGBUS };
+#define EXCEPT_FAULT_SIGNALS (sizeof(exC_fault_signals) / sizeof(exC_fault_signals[0]))
+
+// Actions replaced by `exC_signals_install`, restored by `exC_signals_uninstall`
+static struct sigaction exC_previous_actions[EXCEPT_FAULT_SIGNALS];
+static atomic_bool signals_installed = false;
+
+static void exC_fault_handler(int signum, siginfo_t* info, void* ucontext)
 {
-    if (TSS_CREATE(&stack, stack_tss_free) != THRD_SUCCESS)
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL || ctx->top == 0)
     {
-        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Failed to create exception stack.\n");
-        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        // Nothing can catch it : it goes to the action `exC_signals_install` replaced
+        size_t i = 0;
+        while (i < EXCEPT_FAULT_SIGNALS - 1 && exC_fault_signals[i] != signum)
+            i++;
+        struct sigaction previous = exC_previous_actions[i];
+        if (!(previous.sa_flags & SA_SIGINFO) && (previous.sa_handler == SIG_DFL || previous.sa_handler == SIG_IGN))
+        {
+            // The faulting instruction runs again, with that action
+            sigaction(signum, &previous, NULL);
+            return;
+        }
+        if (previous.sa_flags & SA_RESETHAND)
+        {
+            struct sigaction action = { .sa_handler = SIG_DFL };
+            sigemptyset(&action.sa_mask);
+            sigaction(signum, &action, NULL);
+        }
+        if (previous.sa_flags & SA_SIGINFO)
+            previous.sa_sigaction(signum, info, ucontext);
+        else
+            previous.sa_handler(signum);
+        return;
+    }
+    exC_fault_t fault = { .signal = signum, .code = info->si_code, .address = info->si_addr };
+    switch (signum)
+    {
+        case SIGSEGV:
+            exC_throw_payload(EXCEPT_SEGMENTATION_FAULT, "Segmentation fault", &fault, sizeof(fault));
+        case SIGFPE:
+            exC_throw_payload(EXCEPT_ARITHMETIC_FAULT, "Arithmetic fault", &fault, sizeof(fault));
+        default:
+            exC_throw_payload(EXCEPT_BUS_FAULT, "Bus error", &fault, sizeof(fault));
     }
 }
 
-static void last_exception_what_tss_create(void)
+// Only frees the alternate stack of the calling thread, after disabling it
+static void exC_signal_stack_free(struct exC_thrd_data* data)
 {
-    if (TSS_CREATE(&last_exception_what, last_exception_what_tss_free) != THRD_SUCCESS)
+    if (data->signal_stack == NULL)
+        return;
+    stack_t current;
+    if (sigaltstack(NULL, &current) == 0 && current.ss_sp == data->signal_stack)
     {
-        fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR:" P_RESET " Failed to create WHAT buffer.\n");
-        exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);
+        stack_t disabled = { .ss_flags = SS_DISABLE };
+        sigaltstack(&disabled, NULL);
     }
+    free(data->signal_stack);
+    data->signal_stack = NULL;
 }
+#endif
 
 EXCEPT_API
-void exC_thrd_deinit(void)
+int exC_signals_install(void)
 {
-    // Deallocate the stack and the WHAT buffer (only for the current thread)
-    stack_tss_free(TSS_GET(stack));
-    last_exception_what_tss_free(TSS_GET(last_exception_what));
+#if defined(EXCEPT_HAS_SIGNALS)
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    if (ctx == NULL)
+        return -1;
+    struct exC_thrd_data* data = EXCEPT_THRD_DATA(ctx);
+    if (data->signal_stack == NULL)
+    {
+        // Stack overflows can only be handled on another stack
+        stack_t stack = { .ss_size = EXCEPT_SIGNAL_STACK_SIZE };
+        stack.ss_sp = malloc(EXCEPT_SIGNAL_STACK_SIZE);
+        if (stack.ss_sp == NULL)
+            return -1;
+        if (sigaltstack(&stack, NULL) != 0)
+        {
+            free(stack.ss_sp);
+            return -1;
+        }
+        data->signal_stack = stack.ss_sp;
+    }
+    if (atomic_exchange(&signals_installed, true))
+        return 0;
+    /*
+     * The signal is not blocked while the handler runs : the handler leaves with a plain `longjmp`, so the signal mask
+     * is the one of the interrupted code, and `TRY` blocks do not have to save it.
+     */
+    struct sigaction action = { .sa_sigaction = exC_fault_handler, .sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER };
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < EXCEPT_FAULT_SIGNALS; i++)
+        sigaction(exC_fault_signals[i], &action, &exC_previous_actions[i]);
+    return 0;
+#else
+    return -1;
+#endif
 }
 
 EXCEPT_API
-void exC_global_deinit(void)
+void exC_signals_uninstall(void)
 {
-    // Deallocate the stack and the WHAT buffer (for all threads, i.e. deallocate thread-specific data)
-    TSS_DELETE(stack);
-    TSS_DELETE(last_exception_what);
-}
\ No newline at end of file
+#if defined(EXCEPT_HAS_SIGNALS)
+    if (!atomic_exchange(&signals_installed, false))
+        return;
+    for (size_t i = 0; i < EXCEPT_FAULT_SIGNALS; i++)
+        sigaction(exC_fault_signals[i], &exC_previous_actions[i], NULL);
+#endif
+}
+
+struct exC_task
+{
+    void (*fn)(void*);
+    void* arg;
+};
+
+// Tasks queued for one thread of a group : it runs the newest ones first, and the other threads steal the oldest ones
+struct exC_task_queue
+{
+    MUTEX_T lock;
+    struct exC_task* tasks;
+    size_t capacity;
+    size_t head;
+    size_t size;
+};
+
+struct exC_task_worker
+{
+    struct exC_task_group* group;
+    size_t index;
+};
+
+struct exC_task_group
+{
+    // Queue 0 belongs to the thread that waits for the group, queue `i` to worker `i`
+    size_t worker_count;
+    struct exC_task_queue* queues;
+#if defined(EXCEPT_HAS_THRD_CREATE)
+    THRD_T* threads;
+    struct exC_task_worker* workers;
+#endif
+    // Queue of the next task run from outside of the group
+    atomic_size_t next_queue;
+    // Tasks run and not finished yet
+    atomic_size_t pending;
+    atomic_bool cancelled;
+    atomic_bool stopping;
+    // First exception thrown by a task, and its copy (NULL if it could not be allocated)
+    _Atomic(EXCEPT_EXCEPTION_TYPE) failure;
+    _Atomic(exC_captured_t*) captured;
+};
+
+static bool exC_task_push(struct exC_task_queue* queue, struct exC_task task)
+{
+    MUTEX_LOCK(&queue->lock);
+    if (queue->size == queue->capacity)
+    {
+        size_t capacity = queue->capacity * 2;
+        struct exC_task* tasks = capacity > queue->capacity ? malloc(capacity * sizeof(struct exC_task)) : NULL;
+        if (tasks == NULL)
+        {
+            MUTEX_UNLOCK(&queue->lock);
+            return false;
+        }
+        for (size_t i = 0; i < queue->size; ++i)
+            tasks[i] = queue->tasks[(queue->head + i) % queue->capacity];
+        free(queue->tasks);
+        queue->tasks = tasks;
+        queue->capacity = capacity;
+        queue->head = 0;
+    }
+    queue->tasks[(queue->head + queue->size++) % queue->capacity] = task;
+    MUTEX_UNLOCK(&queue->lock);
+    return true;
+}
+
+static bool exC_task_pop(struct exC_task_queue* queue, struct exC_task* task, bool oldest)
+{
+    MUTEX_LOCK(&queue->lock);
+    bool found = queue->size != 0;
+    if (found)
+    {
+        if (oldest)
+        {
+            *task = queue->tasks[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+        }
+        else
+            *task = queue->tasks[(queue->head + queue->size - 1) % queue->capacity];
+        --queue->size;
+    }
+    MUTEX_UNLOCK(&queue->lock);
+    return found;
+}
+
+// Takes a task of thread `self`, or steals one from the others
+static bool exC_task_find(struct exC_task_group* group, size_t self, struct exC_task* task)
+{
+    if (exC_task_pop(&group->queues[self], task, false))
+        return true;
+    for (size_t i = 1; i <= group->worker_count; ++i)
+    {
+        if (exC_task_pop(&group->queues[(self + i) % (group->worker_count + 1)], task, true))
+            return true;
+    }
+    return false;
+}
+
+static void exC_task_fail(struct exC_task_group* group)
+{
+    atomic_store_explicit(&group->cancelled, true, memory_order_relaxed);
+    EXCEPT_EXCEPTION_TYPE none = 0;
+    // Only the first exception is kept
+    if (atomic_compare_exchange_strong_explicit(&group->failure, &none, exC_last_exception(), memory_order_relaxed, memory_order_relaxed))
+        atomic_store_explicit(&group->captured, exC_capture_current(), memory_order_release);
+}
+
+static void exC_task_execute(struct exC_task_group* group, struct exC_task task)
+{
+    // Tasks that did not start before a task failed are skipped
+    if (!atomic_load_explicit(&group->cancelled, memory_order_relaxed))
+    {
+        EXCEPT_TRY
+        {
+            task.fn(task.arg);
+        }
+        EXCEPT_CATCH()
+        {
+            exC_task_fail(group);
+        }
+        EXCEPT_END_TRY;
+    }
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+// Yields the processor for a while, then sleeps, as long as other threads run the remaining tasks
+static void exC_task_idle(unsigned* idle)
+{
+#if defined(EXCEPT_HAS_THRD_CREATE)
+    if (++*idle < 64)
+        THRD_YIELD();
+    else
+        THRD_SLEEP_US(50);
+#else
+    (void)idle;
+#endif
+}
+
+#if defined(EXCEPT_HAS_THRD_CREATE)
+static THRD_START_T THRD_CALL exC_task_worker_main(void* arg)
+{
+    struct exC_task_worker* worker = arg;
+    struct exC_task_group* group = worker->group;
+    // Without a context, the other threads run the tasks
+    if (exC_thrd_setup() == 0)
+    {
+        unsigned idle = 0;
+        while (!atomic_load_explicit(&group->stopping, memory_order_acquire))
+        {
+            struct exC_task task;
+            if (exC_task_find(group, worker->index, &task))
+            {
+                exC_task_execute(group, task);
+                idle = 0;
+            }
+            else
+                exC_task_idle(&idle);
+        }
+        exC_thrd_deinit();
+    }
+    return 0;
+}
+#endif
+
+static void exC_task_group_free(struct exC_task_group* group, size_t queue_count)
+{
+    for (size_t i = 0; i < queue_count; ++i)
+    {
+        MUTEX_DESTROY(&group->queues[i].lock);
+        free(group->queues[i].tasks);
+    }
+    free(group->queues);
+#if defined(EXCEPT_HAS_THRD_CREATE)
+    free(group->threads);
+    free(group->workers);
+#endif
+    free(group);
+}
+
+EXCEPT_API
+exC_task_group_t* exC_task_group_create(size_t workers)
+{
+#if !defined(EXCEPT_HAS_THRD_CREATE)
+    workers = 0;
+#endif
+    struct exC_task_group* group = calloc(1, sizeof(struct exC_task_group));
+    if (group == NULL)
+        return NULL;
+    group->queues = calloc(workers + 1, sizeof(struct exC_task_queue));
+    bool allocated = group->queues != NULL;
+#if defined(EXCEPT_HAS_THRD_CREATE)
+    group->threads = calloc(workers != 0 ? workers : 1, sizeof(THRD_T));
+    group->workers = calloc(workers != 0 ? workers : 1, sizeof(struct exC_task_worker));
+    allocated = allocated && group->threads != NULL && group->workers != NULL;
+#endif
+    if (!allocated)
+    {
+        exC_task_group_free(group, 0);
+        return NULL;
+    }
+    atomic_init(&group->next_queue, 0);
+    atomic_init(&group->pending, 0);
+    atomic_init(&group->cancelled, false);
+    atomic_init(&group->stopping, false);
+    atomic_init(&group->failure, 0);
+    atomic_init(&group->captured, NULL);
+    for (size_t i = 0; i <= workers; ++i)
+    {
+        struct exC_task_queue* queue = &group->queues[i];
+        queue->capacity = EXCEPT_TASK_QUEUE_SIZE;
+        queue->tasks = malloc(EXCEPT_TASK_QUEUE_SIZE * sizeof(struct exC_task));
+        if (queue->tasks == NULL || MUTEX_INIT(&queue->lock) != THRD_SUCCESS)
+        {
+            free(queue->tasks);
+            exC_task_group_free(group, i);
+            return NULL;
+        }
+    }
+#if defined(EXCEPT_HAS_THRD_CREATE)
+    // The group works with the threads that could be created, if any
+    for (size_t i = 0; i < workers; ++i)
+    {
+        group->workers[i] = (struct exC_task_worker) { .group = group, .index = i + 1 };
+        if (THRD_CREATE(&group->threads[group->worker_count], exC_task_worker_main, &group->workers[i]) != THRD_SUCCESS)
+            break;
+        ++group->worker_count;
+    }
+#endif
+    return group;
+}
+
+EXCEPT_API
+int exC_task_group_run(exC_task_group_t* group, void (*fn)(void*), void* arg)
+{
+    if (group == NULL || fn == NULL)
+        return -1;
+    size_t queue = atomic_fetch_add_explicit(&group->next_queue, 1, memory_order_relaxed) % (group->worker_count + 1);
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    if (!exC_task_push(&group->queues[queue], (struct exC_task) { .fn = fn, .arg = arg }))
+    {
+        atomic_fetch_sub_explicit(&group->pending, 1, memory_order_relaxed);
+        return -1;
+    }
+    return 0;
+}
+
+EXCEPT_API
+int exC_task_group_cancelled(const exC_task_group_t* group)
+{
+    return group != NULL && atomic_load_explicit(&group->cancelled, memory_order_relaxed) ? 1 : 0;
+}
+
+EXCEPT_API
+void exC_task_group_wait(exC_task_group_t* group)
+{
+    if (group == NULL)
+        return;
+    // The waiting thread runs tasks too, until the last one ends
+    unsigned idle = 0;
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) != 0)
+    {
+        struct exC_task task;
+        if (exC_task_find(group, 0, &task))
+        {
+            exC_task_execute(group, task);
+            idle = 0;
+        }
+        else
+            exC_task_idle(&idle);
+    }
+#if defined(EXCEPT_HAS_THRD_CREATE)
+    atomic_store_explicit(&group->stopping, true, memory_order_release);
+    for (size_t i = 0; i < group->worker_count; ++i)
+        THRD_JOIN(group->threads[i]);
+#endif
+    EXCEPT_EXCEPTION_TYPE failure = atomic_load_explicit(&group->failure, memory_order_relaxed);
+    exC_captured_t* captured = atomic_load_explicit(&group->captured, memory_order_acquire);
+    exC_task_group_free(group, group->worker_count + 1);
+    if (captured != NULL)
+        exC_rethrow_captured(captured);
+    if (failure != 0)
+        exC_unwind_static(failure, "");
+}
@@ -25,11 +25,10 @@
 #ifndef EXCEPT_H
 #define EXCEPT_H
 
-// TODO: Implement a STACK_TRACE macro
-
 #include "exCept_user_config.h"
 
 #include <setjmp.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -96,6 +95,20 @@
     #endif
 #endif
 
+#if defined(EXCEPT_THREAD_LOCAL)
+    #undef EXCEPT_THREAD_LOCAL
+#endif
+#if defined(EXCEPT_ONE_THREAD)
+    // Per-thread state is global state
+    #define EXCEPT_THREAD_LOCAL
+#elif defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202300L)
+    #define EXCEPT_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+    #define EXCEPT_THREAD_LOCAL __declspec(thread)
+#else
+    #define EXCEPT_THREAD_LOCAL _Thread_local
+#endif
+
 #if defined(EXCEPT_ARGC) || defined(EXCEPT_ARGC_PRIVATE)
     #undef EXCEPT_ARGC
     #undef EXCEPT_ARGC_PRIVATE
@@ -147,12 +160,113 @@ _ISEMPTY(                                                               \
 #define EXCEPT_FIRST_ARG(...) EXCEPT_FIRST_ARG_PRIVATE(__VA_ARGS__, 0)
 #define EXCEPT_FIRST_ARG_PRIVATE(_first, ...) _first
 
+// Any integer type (e.g. `uint64_t` to encode subsystem, category and error number). 0 is not a valid exception, and
+// the largest values of the type are reserved for the library (see `EXCEPT_UNWINDING` and the exceptions below it).
 #if !defined(EXCEPT_EXCEPTION_TYPE)
     #define EXCEPT_EXCEPTION_TYPE unsigned int
 #endif
+// Size of each thread's arena, holding payloads (see `THROW_WITH`) and cleanups (see `ON_UNWIND`). Define it in
+// `exCept_user_config.h`, as `exCept.c` uses it too.
+#if !defined(EXCEPT_ARENA_SIZE)
+    #define EXCEPT_ARENA_SIZE 1024
+#endif
+// Sizes of the tables of `exC_stats_snapshot`, with `EXCEPT_STATS` (define them in `exCept_user_config.h` too)
+#if !defined(EXCEPT_STATS_CODES)
+    #define EXCEPT_STATS_CODES 64
+#endif
+#if !defined(EXCEPT_STATS_TOP_SITES)
+    #define EXCEPT_STATS_TOP_SITES 8
+#endif
+// Return addresses kept by each sample, with `EXCEPT_SAMPLING` (define it in `exCept_user_config.h` too)
+#if !defined(EXCEPT_SAMPLE_DEPTH)
+    #define EXCEPT_SAMPLE_DEPTH 16
+#endif
+// Reserved : blocks resumed to run their `FINALLY` clause see it as their exception, and no `CATCH` clause runs
+#if !defined(EXCEPT_UNWINDING)
+    #define EXCEPT_UNWINDING ((EXCEPT_EXCEPTION_TYPE) -1)
+#endif
+// Thrown by `TRY` when the exception stack can not grow anymore (see `exC_global_setup`). Not a literal : catch it with
+// `CATCH_ANY_OF`.
+#if !defined(EXCEPT_STACK_OVERFLOW)
+    #define EXCEPT_STACK_OVERFLOW ((EXCEPT_EXCEPTION_TYPE) -2)
+#endif
+// Thrown by the faults of threads that called `exC_signals_install` (SIGSEGV, SIGFPE and SIGBUS), with an `exC_fault_t`
+// payload
+#if !defined(EXCEPT_SEGMENTATION_FAULT)
+    #define EXCEPT_SEGMENTATION_FAULT ((EXCEPT_EXCEPTION_TYPE) -3)
+#endif
+#if !defined(EXCEPT_ARITHMETIC_FAULT)
+    #define EXCEPT_ARITHMETIC_FAULT ((EXCEPT_EXCEPTION_TYPE) -4)
+#endif
+#if !defined(EXCEPT_BUS_FAULT)
+    #define EXCEPT_BUS_FAULT ((EXCEPT_EXCEPTION_TYPE) -5)
+#endif
+// Codes may carry a category in their high bits : `EXCEPT_MAKE_CODE(category, n)`, with 1 <= n <= EXCEPT_CATEGORY_MAX_CODE
+#if !defined(EXCEPT_CATEGORY_SHIFT)
+    #define EXCEPT_CATEGORY_SHIFT 16
+#endif
+#if defined(EXCEPT_MAKE_CODE) || defined(EXCEPT_CATEGORY_OF) || defined(EXCEPT_CATEGORY_MAX_CODE)
+    #undef EXCEPT_MAKE_CODE
+    #undef EXCEPT_CATEGORY_OF
+    #undef EXCEPT_CATEGORY_MAX_CODE
+#endif
+#define EXCEPT_CATEGORY_MAX_CODE (((EXCEPT_EXCEPTION_TYPE) 1 << EXCEPT_CATEGORY_SHIFT) - 1)
+#define EXCEPT_MAKE_CODE(_category, _n) \
+    (((EXCEPT_EXCEPTION_TYPE) (_category) << EXCEPT_CATEGORY_SHIFT) | (EXCEPT_EXCEPTION_TYPE) (_n))
+#define EXCEPT_CATEGORY_OF(_code) ((_code) >> EXCEPT_CATEGORY_SHIFT)
 #if !defined(EXCEPT_TYPEOF)
     #define EXCEPT_TYPEOF(_var) __typeof__(_var)
 #endif
+
+#if defined(EXCEPT_SETJMP) || defined(EXCEPT_LONGJMP) || defined(EXCEPT_DISPATCH) || defined(EXCEPT_CAUGHT_EXCEPTION)
+    #undef EXCEPT_SETJMP
+    #undef EXCEPT_LONGJMP
+    #undef EXCEPT_DISPATCH
+    #undef EXCEPT_CAUGHT_EXCEPTION
+#endif
+/*
+ * The value passed to `longjmp` only tells that something has been thrown : the exception itself is stored in the
+ * thread's context, at full width (see `EXCEPT_EXCEPTION_TYPE`), and read back by `EXCEPT_DISPATCH`.
+ */
+#if defined(EXCEPT_USE_FAST_CONTEXT)
+    #if !defined(__GNUC__) && !defined(__clang__)
+        #error "EXCEPT_USE_FAST_CONTEXT requires GCC or Clang."
+    #endif
+    /*
+     * Only the callee-saved registers, the stack pointer and the resume address are stored, by a few instructions of
+     * assembly (see `exCept.c`). There is no signal mask and no pointer mangling. Being `returns_twice`, the saving
+     * function is handled by the compiler exactly like `setjmp`.
+     */
+    #if defined(__x86_64__) && !defined(__ILP32__) && !defined(_WIN32)
+        // rbx, rbp, r12 to r15, the stack pointer, the resume address and the shadow stack pointer
+        typedef void* exC_jmp_buf[9];
+    #elif defined(__aarch64__) && !defined(__ILP32__) && !defined(_WIN32)
+        // x19 to x30, the stack pointer and d8 to d15
+        typedef void* exC_jmp_buf[21];
+    #else
+        #error "EXCEPT_USE_FAST_CONTEXT is only available on x86_64 and aarch64 (outside of Windows)."
+    #endif
+    EXCEPT_API __attribute__((__returns_twice__)) int exC_fast_setjmp(exC_jmp_buf env);
+    EXCEPT_API __attribute__((__noreturn__)) void exC_fast_longjmp(exC_jmp_buf env);
+    #define EXCEPT_SETJMP(_env) exC_fast_setjmp(_env)
+    #define EXCEPT_LONGJMP(_env) exC_fast_longjmp(_env)
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+    // BSD `setjmp` saves the signal mask with a system call, which is never needed (see `exC_signals_install`)
+    typedef jmp_buf exC_jmp_buf;
+    #define EXCEPT_SETJMP(_env) _setjmp(_env)
+    #define EXCEPT_LONGJMP(_env) _longjmp(_env, 1)
+#else
+    typedef jmp_buf exC_jmp_buf;
+    #define EXCEPT_SETJMP(_env) setjmp(_env)
+    #define EXCEPT_LONGJMP(_env) longjmp(_env, 1)
+#endif
+#if defined(EXCEPT_INLINE_FAST_PATH)
+    #define EXCEPT_CAUGHT_EXCEPTION() (EXCEPT_CONTEXT()->last_exception)
+#else
+    #define EXCEPT_CAUGHT_EXCEPTION() exC_last_exception()
+#endif
+// What the `switch` of a `TRY` block dispatches on : 0 for the `TRY` clause itself, the exception for `CATCH` clauses
+#define EXCEPT_DISPATCH(_env) (EXCEPT_SETJMP(_env) ? EXCEPT_CAUGHT_EXCEPTION() : (EXCEPT_EXCEPTION_TYPE) 0)
 #if !defined(EXCEPT_TERM_HANDLER_SIG)
     typedef void (*term_handler_t)(int);
     #define EXCEPT_TERM_HANDLER_SIG term_handler_t
@@ -235,8 +349,8 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
 #define EXCEPT_SAVE_PRIVATE_ARITY 1
 #define EXCEPT_SAVE(...) ML99_EVAL(ML99_call(ML99_variadicsForEach, v(EXCEPT_SAVE_PRIVATE), v(__VA_ARGS__)))
 
-#if defined(EXCEPT_TRY_WITH_ARG) || defined(EXCEPT_CATCH) || defined(EXCEPT_THROW) || defined(EXCEPT_FINALLY) || defined(EXCEPT_END_TRY) || defined(EXCEPT_RETHROW) || defined(EXCEPT_VAR) || defined(EXCEPT_CATCH_NUM) || defined(EXCEPT_CATCH_UNNAMED) || defined(EXCEPT_CATCH_NAMED_VAR) || defined(EXCEPT_TERMINATE) || defined(NOEXCEPT) || defined(END_NOEXCEPT) || defined(EXCEPT_TRY) || defined(EXCEPT_WHAT)
-    #warning "One or most of EXCEPT_TRY_WITH_ARG, EXCEPT_CATCH, EXCEPT_THROW, EXCEPT_FINALLY, EXCEPT_END_TRY, EXCEPT_RETHROW, EXCEPT_VAR, EXCEPT_CATCH_NUM, EXCEPT_CATCH_UNNAMED, EXCEPT_CATCH_NAMED_VAR, EXCEPT_TERMINATE, NOEXCEPT, END_NOEXCEPT, EXCEPT_TRY and EXCEPT_WHAT are already defined. Undefining them."
+#if defined(EXCEPT_TRY_WITH_ARG) || defined(EXCEPT_CATCH) || defined(EXCEPT_THROW) || defined(EXCEPT_FINALLY) || defined(EXCEPT_ON_UNWIND) || defined(EXCEPT_END_TRY) || defined(EXCEPT_RETHROW) || defined(EXCEPT_VAR) || defined(EXCEPT_CATCH_NUM) || defined(EXCEPT_CATCH_UNNAMED) || defined(EXCEPT_CATCH_NAMED_VAR) || defined(EXCEPT_TERMINATE) || defined(EXCEPT_STACK_TRACE) || defined(NOEXCEPT) || defined(END_NOEXCEPT) || defined(EXCEPT_TRY) || defined(EXCEPT_WHAT) || defined(EXCEPT_THROW_COPY) || defined(EXCEPT_THROWF) || defined(EXCEPT_THROW_WITH) || defined(EXCEPT_CATCH_PAYLOAD) || defined(EXCEPT_CATCH_CASES) || defined(EXCEPT_CATCH_ANY_OF) || defined(EXCEPT_CATCH_RANGE) || defined(EXCEPT_CATCH_CATEGORY)
+    #warning "One or most of EXCEPT_TRY_WITH_ARG, EXCEPT_CATCH, EXCEPT_THROW, EXCEPT_FINALLY, EXCEPT_ON_UNWIND, EXCEPT_END_TRY, EXCEPT_RETHROW, EXCEPT_VAR, EXCEPT_CATCH_NUM, EXCEPT_CATCH_UNNAMED, EXCEPT_CATCH_NAMED_VAR, EXCEPT_TERMINATE, EXCEPT_STACK_TRACE, NOEXCEPT, END_NOEXCEPT, EXCEPT_TRY, EXCEPT_WHAT, EXCEPT_THROW_COPY, EXCEPT_THROWF, EXCEPT_THROW_WITH, EXCEPT_CATCH_PAYLOAD, EXCEPT_CATCH_CASES, EXCEPT_CATCH_ANY_OF, EXCEPT_CATCH_RANGE and EXCEPT_CATCH_CATEGORY are already defined. Undefining them."
     #undef EXCEPT_TRY_WITH_ARG
     #undef EXCEPT_CATCH
     #undef EXCEPT_CATCH_NUM
@@ -244,21 +358,66 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
     #undef EXCEPT_CATCH_NAMED_VAR
     #undef EXCEPT_THROW
     #undef EXCEPT_FINALLY
+    #undef EXCEPT_ON_UNWIND
     #undef EXCEPT_END_TRY
     #undef EXCEPT_RETHROW
     #undef EXCEPT_VAR
     #undef EXCEPT_TERMINATE
+    #undef EXCEPT_STACK_TRACE
     #undef NOEXCEPT
     #undef END_NOEXCEPT
     #undef EXCEPT_TRY
     #undef EXCEPT_WHAT
+    #undef EXCEPT_THROW_COPY
+    #undef EXCEPT_THROWF
+    #undef EXCEPT_THROW_WITH
+    #undef EXCEPT_CATCH_PAYLOAD
+    #undef EXCEPT_CATCH_CASES
+    #undef EXCEPT_CATCH_ANY_OF
+    #undef EXCEPT_CATCH_ANY_OF_PRIVATE
+    #undef EXCEPT_CATCH_ANY_OF_PRIVATE_IMPL
+    #undef EXCEPT_CATCH_ANY_OF_PRIVATE_ARITY
+    #undef EXCEPT_CATCH_RANGE
+    #undef EXCEPT_CATCH_CATEGORY
+#endif
+
+#if defined(EXCEPT_SETUP_DONE) || defined(EXCEPT_PUSH_STACK) || defined(EXCEPT_POP_STACK) || defined(EXCEPT_PUSH_NOEXCEPT) \
+    || defined(EXCEPT_NOEXCEPT_FRAME) || defined(EXCEPT_NOEXCEPT_GUARD) || defined(EXCEPT_NOEXCEPT_END)
+    #undef EXCEPT_SETUP_DONE
+    #undef EXCEPT_PUSH_STACK
+    #undef EXCEPT_POP_STACK
+    #undef EXCEPT_PUSH_NOEXCEPT
+    #undef EXCEPT_NOEXCEPT_FRAME
+    #undef EXCEPT_NOEXCEPT_GUARD
+    #undef EXCEPT_NOEXCEPT_END
+#endif
+#if defined(EXCEPT_ONE_THREAD)
+    // A missing setup makes the push fail instead (there is no stack to push to)
+    #define EXCEPT_SETUP_DONE() 1
+#elif defined(EXCEPT_INLINE_FAST_PATH)
+    #define EXCEPT_SETUP_DONE() (EXCEPT_CONTEXT() != NULL)
+#else
+    #define EXCEPT_SETUP_DONE() (exC_is_global_setup_done() && exC_is_thread_setup_done())
+#endif
+// Entry pushed by `NOEXCEPT`, which is never jumped to
+#define EXCEPT_NOEXCEPT_FRAME ((exC_jmp_buf*) (void*) &exC_noexcept_marker)
+#if defined(EXCEPT_INLINE_FAST_PATH)
+    // Everything is reached through `EXCEPT_CONTEXT()`, so that a `TRY` block does not call into the library unless
+    // something goes wrong (stack not created, overflow)
+    #define EXCEPT_PUSH_STACK(_env) exC_inline_push_stack(_env)
+    #define EXCEPT_POP_STACK() exC_inline_pop_stack()
+    #define EXCEPT_PUSH_NOEXCEPT() (EXCEPT_CONTEXT() != NULL ? exC_inline_push_stack(EXCEPT_NOEXCEPT_FRAME) : -1)
+#else
+    #define EXCEPT_PUSH_STACK(_env) exC_push_stack(_env)
+    #define EXCEPT_POP_STACK() exC_pop_stack()
+    #define EXCEPT_PUSH_NOEXCEPT() exC_push_stack(EXCEPT_NOEXCEPT_FRAME)
 #endif
 
 // TODO: Modify macros
 #define EXCEPT_TRY_WITH_ARG(_nesting_lvl)                                         \
     do                                                                            \
     {                                                                             \
-        if (!exC_is_global_setup_done() || !exC_is_thread_setup_done())           \
+        if (!EXCEPT_SETUP_DONE())                                                 \
         {                                                                         \
             fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR: " P_RESET                 \
                             "exC_global_setup and/or exC_thread_setup have not "  \
@@ -266,8 +425,8 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
                             "the macros provided by exCept.h.\n");                \
             exit(EXIT_FAILURE);                                                   \
         }                                                                         \
-        jmp_buf EXCEPT_NAMESPACE(EXCEPT_CAT(env, _nesting_lvl));                  \
-        if (exC_push_stack(&EXCEPT_NAMESPACE(EXCEPT_CAT(env, _nesting_lvl))) != 0)\
+        exC_jmp_buf EXCEPT_NAMESPACE(EXCEPT_CAT(env, _nesting_lvl));              \
+        if (EXCEPT_PUSH_STACK(&EXCEPT_NAMESPACE(EXCEPT_CAT(env, _nesting_lvl))) != 0)\
         {                                                                         \
             fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR: " P_RESET                 \
                             "exC_push_stack failed. Please check that the stack " \
@@ -275,7 +434,7 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
                             "sufficient.\n");                                     \
             exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);                          \
         }                                                                         \
-        switch (setjmp(EXCEPT_NAMESPACE(EXCEPT_CAT(env, _nesting_lvl))))          \
+        switch (EXCEPT_DISPATCH(EXCEPT_NAMESPACE(EXCEPT_CAT(env, _nesting_lvl)))) \
         {                                                                         \
             case 0:                                                               \
                 {
@@ -284,7 +443,7 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
 #define EXCEPT_TRY                                                                  \
     do                                                                              \
     {                                                                               \
-        if (!exC_is_global_setup_done() || !exC_is_thread_setup_done())             \
+        if (!EXCEPT_SETUP_DONE())                                                   \
         {                                                                           \
             fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR: " P_RESET                   \
                             "exC_global_setup and/or exC_thread_setup have not "    \
@@ -292,8 +451,8 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
                             "the macros provided by exCept.h.\n");                  \
             exit(EXIT_FAILURE);                                                     \
         }                                                                           \
-        jmp_buf EXCEPT_NAMESPACE(EXCEPT_CAT(env, __COUNTER__));                     \
-        if (exC_push_stack(                                                         \
+        exC_jmp_buf EXCEPT_NAMESPACE(EXCEPT_CAT(env, __COUNTER__));                 \
+        if (EXCEPT_PUSH_STACK(                                                      \
             &EXCEPT_NAMESPACE(EXCEPT_CAT(env, EXCEPT_SUB(__COUNTER__, 1)))) != 0)   \
         {                                                                           \
             fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR: " P_RESET                   \
@@ -302,40 +461,89 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
                             "sufficient.\n");                                       \
             exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);                            \
         }                                                                           \
-        switch (                                                                    \
-            setjmp(EXCEPT_NAMESPACE(EXCEPT_CAT(env, EXCEPT_SUB(__COUNTER__, 2)))))  \
+        switch (EXCEPT_DISPATCH(                                                    \
+            EXCEPT_NAMESPACE(EXCEPT_CAT(env, EXCEPT_SUB(__COUNTER__, 2)))))         \
         {                                                                           \
             case 0:                                                                 \
                 {
 #elif defined(__LINE__)
 #define EXCEPT_TRY                                                                  \
-    do{if(!exC_is_global_setup_done()||!exC_is_thread_setup_done()){fprintf(stderr,P_RED P_BOLD "EXCEPT ERROR: " P_RESET "exC_global_setup and/or exC_thread_setup have not been called. Please call them before using any of the macros provided by exCept.h.\n");exit(EXIT_FAILURE);}jmp_buf EXCEPT_NAMESPACE(EXCEPT_CAT(env,__LINE__));if(exC_push_stack(&EXCEPT_NAMESPACE(EXCEPT_CAT(env,__LINE__)))!=0){fprintf(stderr,P_RED P_BOLD "EXCEPT ERROR: " P_RESET "exC_push_stack failed. Please check that the stack has been created and that the stack size is sufficient.\n");exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);}switch(setjmp(EXCEPT_NAMESPACE(EXCEPT_CAT(env,__LINE__)))){case 0:{
+    do{if(!EXCEPT_SETUP_DONE()){fprintf(stderr,P_RED P_BOLD "EXCEPT ERROR: " P_RESET "exC_global_setup and/or exC_thread_setup have not been called. Please call them before using any of the macros provided by exCept.h.\n");exit(EXIT_FAILURE);}exC_jmp_buf EXCEPT_NAMESPACE(EXCEPT_CAT(env,__LINE__));if(EXCEPT_PUSH_STACK(&EXCEPT_NAMESPACE(EXCEPT_CAT(env,__LINE__)))!=0){fprintf(stderr,P_RED P_BOLD "EXCEPT ERROR: " P_RESET "exC_push_stack failed. Please check that the stack has been created and that the stack size is sufficient.\n");exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS);}switch(EXCEPT_DISPATCH(EXCEPT_NAMESPACE(EXCEPT_CAT(env,__LINE__)))){case 0:{
 #else
     #error "Neither __COUNTER__ nor __LINE__ are defined. Cannot use EXCEPT_TRY."
 #endif
 
+#if defined(EXCEPT_THROW_SITE) || defined(EXCEPT_ON_CATCH)
+    #undef EXCEPT_THROW_SITE
+    #undef EXCEPT_ON_CATCH
+#endif
+// Statistics need to know where exceptions are thrown, and statistics and the flight recorder when they are caught
+#if defined(EXCEPT_STATS)
+    #define EXCEPT_THROW_SITE() exC_throw_site(__FILE__, __LINE__)
+#else
+    #define EXCEPT_THROW_SITE() ((void) 0)
+#endif
+#if defined(EXCEPT_STATS) || defined(EXCEPT_FLIGHT_RECORDER)
+    #define EXCEPT_ON_CATCH() exC_on_catch()
+#else
+    #define EXCEPT_ON_CATCH() ((void) 0)
+#endif
+
+// The block is popped once, by `END_TRY`, whichever clause ran (if any)
 #define EXCEPT_CATCH_NUM(x)      \
                 }                \
-                exC_pop_stack(); \
                 break;           \
             case x:              \
+                EXCEPT_ON_CATCH(); \
                 {
 
-#define EXCEPT_CATCH_UNNAMED     \
-                }                \
-                exC_pop_stack(); \
-                break;           \
-            default:             \
+#define EXCEPT_CATCH_UNNAMED                                        \
+                }                                                   \
+                break;                                              \
+            default:                                                \
+                if (EXCEPT_CAUGHT_EXCEPTION() == EXCEPT_UNWINDING)  \
+                    break;                                          \
+                EXCEPT_ON_CATCH();                                  \
                 {
 
 #define EXCEPT_CATCH_NAMED_VAR(_var)                                \
                 }                                                   \
-                exC_pop_stack();                                    \
                 break;                                              \
             default:                                                \
                 EXCEPT_EXCEPTION_TYPE _var = exC_last_exception();  \
+                if (_var == EXCEPT_UNWINDING)                       \
+                    break;                                          \
+                EXCEPT_ON_CATCH();                                  \
+                {
+
+// Every clause below is a set of `case` labels of the same `switch`, so that the compiler can still emit a jump table
+#define EXCEPT_CATCH_CASES(...)  \
+                }                \
+                break;           \
+            __VA_ARGS__          \
+                EXCEPT_ON_CATCH(); \
                 {
 
+#define EXCEPT_CATCH_ANY_OF_PRIVATE_IMPL(_except) v(case _except:)
+#define EXCEPT_CATCH_ANY_OF_PRIVATE_ARITY 1
+#define EXCEPT_CATCH_ANY_OF(...) \
+    EXCEPT_CATCH_CASES(ML99_EVAL(ML99_call(ML99_variadicsForEach, v(EXCEPT_CATCH_ANY_OF_PRIVATE), v(__VA_ARGS__))))
+
+#if defined(__GNUC__) || defined(__clang__)
+    // Case ranges are a GNU extension
+    #define EXCEPT_CATCH_RANGE(_lo, _hi) EXCEPT_CATCH_CASES(case (_lo) ... (_hi):)
+#else
+    #define EXCEPT_CATCH_RANGE(_lo, _hi) \
+        EXCEPT_CATCH_CASES(static_assert(0, "CATCH_RANGE and CATCH_CATEGORY need a compiler supporting case ranges.");)
+#endif
+// Code 0 of each category is not part of it, so that category 0 is made of the plain codes
+#define EXCEPT_CATCH_CATEGORY(_category) \
+    EXCEPT_CATCH_RANGE(EXCEPT_MAKE_CODE(_category, 1), EXCEPT_MAKE_CODE(_category, EXCEPT_CATEGORY_MAX_CODE))
+
+// `_var` points to the payload thrown with `THROW_WITH`, or is NULL if there is none of this type
+#define EXCEPT_CATCH_PAYLOAD(x, _type, _var) \
+    EXCEPT_CATCH_CASES(case x:) const _type* _var = exC_last_payload(sizeof(_type));
+
 #define EXCEPT_CATCH(...) \
     CHAOS_PP_VARIADIC_IF(CHAOS_PP_EQUAL(EXCEPT_ARGC(__VA_ARGS__), 1))               \
     (                                                                               \
@@ -357,36 +565,117 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
     #undef EXCEPT_ARG_1_AND_2
 #endif
 #define EXCEPT_ARG_1_AND_2(_1, _2, ...) _1, _2
-#define EXCEPT_THROW(...) exC_unwind(EXCEPT_ARG_1_AND_2(__VA_ARGS__, NULL), NULL)
+#if defined(EXCEPT_WHAT_IS_STATIC)
+    #undef EXCEPT_WHAT_IS_STATIC
+#endif
+// Whether the `WHAT` message outlives the exception, so that only its address needs to be stored
+#if defined(EXCEPT_WHAT_ZERO_COPY)
+    #define EXCEPT_WHAT_IS_STATIC(_what) 1
+#elif defined(__GNUC__) || defined(__clang__)
+    // True for string literals (and NULL), false for anything that could be a temporary buffer
+    #define EXCEPT_WHAT_IS_STATIC(_what) __builtin_constant_p(_what)
+#else
+    #define EXCEPT_WHAT_IS_STATIC(_what) 0
+#endif
+#define EXCEPT_THROW_PRIVATE_IMPL(_except, _what) \
+    (EXCEPT_THROW_SITE(),                         \
+     EXCEPT_WHAT_IS_STATIC(_what)                 \
+        ? exC_unwind_static(_except, _what)       \
+        : exC_unwind(_except, _what, NULL))
+#define EXCEPT_THROW_PRIVATE(...) EXCEPT_THROW_PRIVATE_IMPL(__VA_ARGS__)
+#define EXCEPT_THROW(...) EXCEPT_THROW_PRIVATE(EXCEPT_ARG_1_AND_2(__VA_ARGS__, NULL))
+#define EXCEPT_THROW_COPY(_except, _what) (EXCEPT_THROW_SITE(), exC_unwind(_except, _what, NULL))
+// The arguments are captured, and only formatted when `WHAT` is read (a non-literal format is formatted right away)
+#define EXCEPT_THROWF(_except, ...) \
+    (EXCEPT_THROW_SITE(), exC_unwind_fmt(_except, EXCEPT_WHAT_IS_STATIC(EXCEPT_FIRST_ARG(__VA_ARGS__)), __VA_ARGS__))
+
+// The value is copied in the thread's arena, which is released when the `CATCH` clause completes
+#define EXCEPT_THROW_WITH(_except, _type, _value)                                                       \
+    do                                                                                                  \
+    {                                                                                                   \
+        static_assert(sizeof(_type) <= EXCEPT_ARENA_SIZE, "Payload larger than the exception arena.");  \
+        _type EXCEPT_NAMESPACE(payload) = (_value);                                                     \
+        EXCEPT_THROW_SITE();                                                                            \
+        exC_unwind_payload(_except, &EXCEPT_NAMESPACE(payload), sizeof(_type));                         \
+    } while (0)
 
 #define EXCEPT_END_TRY           \
                 }                \
-                exC_pop_stack(); \
                 break;           \
         }                        \
+        EXCEPT_POP_STACK();      \
     } while (0)
 
-#define EXCEPT_RETHROW exC_unwind(exC_last_exception(), exC_last_exception_what(), NULL)
+#define EXCEPT_RETHROW exC_rethrow()
 
 #define EXCEPT_VAR(_var) EXCEPT_NAMESPACE(EXCEPT_CAT(saved_var_, _var))
 
-#define EXCEPT_FINALLY
+// Runs whichever way the `TRY` and `CATCH` clauses are left. When an exception left a `CATCH` clause, it goes on at
+// `END_TRY`.
+#define EXCEPT_FINALLY                  \
+                }                       \
+                break;                  \
+        }                               \
+        switch (exC_enter_finally())    \
+        {                               \
+            default:                    \
+                {
+
+#define EXCEPT_ON_UNWIND(_fn, _arg) exC_on_unwind(_fn, _arg)
 
 #define EXCEPT_TERMINATE(status, ...) exC_terminate(status, __VA_ARGS__)
 
+// Prints where the last exception was thrown (needs `EXCEPT_CAPTURE_STACK_TRACE`, see `exC_stack_trace`)
+#define EXCEPT_STACK_TRACE(stream) exC_print_stack_trace(stream)
+
+#if defined(EXCEPT_DEBUG_NOEXCEPT)
+// A full block, catching what reaches it
 #define NOEXCEPT EXCEPT_TRY_WITH_ARG(EXCEPT_CAT(__LINE__, __COUNTER__)) {
 
-#define END_NOEXCEPT } EXCEPT_CATCH_UNNAMED { EXCEPT_TERMINATE(TERMINATE_DEFAULT_ERROR_ARGS); } EXCEPT_END_TRY;
+#define END_NOEXCEPT } EXCEPT_CATCH_UNNAMED { exC_terminate(TERMINATE_DEFAULT_ERROR_ARGS); } EXCEPT_END_TRY;
+#else
+#if defined(__GNUC__) || defined(__clang__)
+    // The marker is popped whichever way the block is left (`break`, `continue`, `return` and `goto` included)
+    #define EXCEPT_NOEXCEPT_GUARD __attribute__((__cleanup__(exC_noexcept_end))) char EXCEPT_NAMESPACE(noexcept_guard) = 0;
+    #define EXCEPT_NOEXCEPT_END
+#else
+    #define EXCEPT_NOEXCEPT_GUARD
+    #define EXCEPT_NOEXCEPT_END EXCEPT_POP_STACK();
+#endif
+// Only a marker entry on the exception stack : a throw reaching it terminates (see `exC_unwind`), so nothing is saved
+#define NOEXCEPT                                                                    \
+    {                                                                               \
+        if (EXCEPT_PUSH_NOEXCEPT() != 0)                                            \
+        {                                                                           \
+            fprintf(stderr, P_RED P_BOLD "EXCEPT ERROR: " P_RESET                   \
+                            "exC_global_setup and/or exC_thread_setup have not "    \
+                            "been called. Please call them before using any of "    \
+                            "the macros provided by exCept.h.\n");                  \
+            exit(EXIT_FAILURE);                                                     \
+        }                                                                           \
+        EXCEPT_NOEXCEPT_GUARD                                                       \
+        {
+
+#define END_NOEXCEPT } EXCEPT_NOEXCEPT_END }
+#endif
 
 #define EXCEPT_WHAT exC_last_exception_what()
 
 #if defined(EXCEPT_LOWERCASE)
-    #if defined(try) || defined(catch) || defined(throw) || defined(finally) || defined(end_try) || defined(rethrow) || defined(load) || defined(sync_changes) || defined(save) || defined(var) || defined(terminate) || defined(noexcept) || defined(end_noexcept) || defined(what)
-        #warning "One or most of try, catch, throw, finally, end_try, rethrow, load, sync_changes, save, var, terminate, noexcept, end_noexcept and what are already defined. Undefining them."
+    #if defined(try) || defined(catch) || defined(throw) || defined(throw_copy) || defined(throwf) || defined(throw_with) || defined(catch_payload) || defined(catch_any_of) || defined(catch_range) || defined(catch_category) || defined(finally) || defined(on_unwind) || defined(end_try) || defined(rethrow) || defined(load) || defined(sync_changes) || defined(save) || defined(var) || defined(terminate) || defined(stack_trace) || defined(noexcept) || defined(end_noexcept) || defined(what)
+        #warning "One or most of try, catch, throw, throw_copy, throwf, throw_with, catch_payload, catch_any_of, catch_range, catch_category, finally, on_unwind, end_try, rethrow, load, sync_changes, save, var, terminate, stack_trace, noexcept, end_noexcept and what are already defined. Undefining them."
         #undef try
         #undef catch
         #undef throw
+        #undef throw_copy
+        #undef throwf
+        #undef throw_with
+        #undef catch_payload
+        #undef catch_any_of
+        #undef catch_range
+        #undef catch_category
         #undef finally
+        #undef on_unwind
         #undef end_try
         #undef rethrow
         #undef load
@@ -394,6 +683,7 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
         #undef save
         #undef var
         #undef terminate
+        #undef stack_trace
         #undef noexcept
         #undef end_noexcept
         #undef what
@@ -401,15 +691,24 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
     #define try EXCEPT_TRY
     #define catch(...) EXCEPT_CATCH(__VA_ARGS__)
     #define throw(...)                                                                                                  \
+    do                                                                                                                  \
     {                                                                                                                   \
         static_assert(                                                                                                  \
             EXCEPT_ARGC(__VA_ARGS__) == 2 ||                                                                            \
             EXCEPT_ARGC(__VA_ARGS__) == 1 ||                                                                            \
             EXCEPT_ARGC(__VA_ARGS__) == 0,                                                                              \
             "throw takes 0, 1 or 2 arguments.");                                                                        \
-    }                                                                                                                   \
-    ML99_EVAL(ML99_if(ML99_or(ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(2)), ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(1))), v(EXCEPT_THROW(__VA_ARGS__)), v(EXCEPT_RETHROW)))
+        ML99_EVAL(ML99_if(ML99_or(ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(2)), ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(1))), v(EXCEPT_THROW(__VA_ARGS__)), v(EXCEPT_RETHROW))); \
+    } while (0)
+    #define throw_copy(_except, _what) EXCEPT_THROW_COPY(_except, _what)
+    #define throwf(_except, ...) EXCEPT_THROWF(_except, __VA_ARGS__)
+    #define throw_with(_except, _type, _value) EXCEPT_THROW_WITH(_except, _type, _value)
+    #define catch_payload(x, _type, _var) EXCEPT_CATCH_PAYLOAD(x, _type, _var)
+    #define catch_any_of(...) EXCEPT_CATCH_ANY_OF(__VA_ARGS__)
+    #define catch_range(_lo, _hi) EXCEPT_CATCH_RANGE(_lo, _hi)
+    #define catch_category(_category) EXCEPT_CATCH_CATEGORY(_category)
     #define finally EXCEPT_FINALLY
+    #define on_unwind(_fn, _arg) EXCEPT_ON_UNWIND(_fn, _arg)
     #define end_try EXCEPT_END_TRY
     #define rethrow EXCEPT_RETHROW
     #define load(...) EXCEPT_LOAD(__VA_ARGS__)
@@ -417,16 +716,25 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
     #define save(...) EXCEPT_SAVE(__VA_ARGS__)
     #define var(...) EXCEPT_VAR(__VA_ARGS__)
     #define terminate(status, ...) EXCEPT_TERMINATE(status, __VA_ARGS__)
+    #define stack_trace(stream) EXCEPT_STACK_TRACE(stream)
     #define noexcept NOEXCEPT
     #define end_noexcept END_NOEXCEPT
     #define what EXCEPT_WHAT
 #else
-    #if defined(TRY) || defined(CATCH) || defined(THROW) || defined(FINALLY) || defined(END_TRY) || defined(RETHROW) || defined(LOAD) || defined(SYNC_CHANGES) || defined(SAVE) || defined(VAR) || defined(TERMINATE) || defined(WHAT)
-        #warning "One or most of TRY, CATCH, THROW, FINALLY, END_TRY, RETHROW, LOAD, SYNC_CHANGES, SAVE, VAR, TERMINATE and WHAT are already defined. Undefining them."
+    #if defined(TRY) || defined(CATCH) || defined(THROW) || defined(THROW_COPY) || defined(THROWF) || defined(THROW_WITH) || defined(CATCH_PAYLOAD) || defined(CATCH_ANY_OF) || defined(CATCH_RANGE) || defined(CATCH_CATEGORY) || defined(FINALLY) || defined(ON_UNWIND) || defined(END_TRY) || defined(RETHROW) || defined(LOAD) || defined(SYNC_CHANGES) || defined(SAVE) || defined(VAR) || defined(TERMINATE) || defined(STACK_TRACE) || defined(WHAT)
+        #warning "One or most of TRY, CATCH, THROW, THROW_COPY, THROWF, THROW_WITH, CATCH_PAYLOAD, CATCH_ANY_OF, CATCH_RANGE, CATCH_CATEGORY, FINALLY, ON_UNWIND, END_TRY, RETHROW, LOAD, SYNC_CHANGES, SAVE, VAR, TERMINATE, STACK_TRACE and WHAT are already defined. Undefining them."
         #undef TRY
         #undef CATCH
         #undef THROW
+        #undef THROW_COPY
+        #undef THROWF
+        #undef THROW_WITH
+        #undef CATCH_PAYLOAD
+        #undef CATCH_ANY_OF
+        #undef CATCH_RANGE
+        #undef CATCH_CATEGORY
         #undef FINALLY
+        #undef ON_UNWIND
         #undef END_TRY
         #undef RETHROW
         #undef LOAD
@@ -434,20 +742,30 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
         #undef SAVE
         #undef VAR
         #undef TERMINATE
+        #undef STACK_TRACE
         #undef WHAT
     #endif
     #define TRY EXCEPT_TRY
     #define CATCH(...) EXCEPT_CATCH(__VA_ARGS__)
     #define THROW(...)                                                                                                  \
+    do                                                                                                                  \
     {                                                                                                                   \
         static_assert(                                                                                                  \
             EXCEPT_ARGC(__VA_ARGS__) == 2 ||                                                                            \
             EXCEPT_ARGC(__VA_ARGS__) == 1 ||                                                                            \
             EXCEPT_ARGC(__VA_ARGS__) == 0,                                                                              \
             "THROW takes 0, 1 or 2 arguments.");                                                                        \
-    }                                                                                                                   \
-    ML99_EVAL(ML99_if(ML99_or(ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(2)), ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(1))), v(EXCEPT_THROW(__VA_ARGS__, NULL)), v(EXCEPT_RETHROW)))
+        ML99_EVAL(ML99_if(ML99_or(ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(2)), ML99_natEq(v(EXCEPT_ARGC(__VA_ARGS__)), v(1))), v(EXCEPT_THROW(__VA_ARGS__, NULL)), v(EXCEPT_RETHROW))); \
+    } while (0)
+    #define THROW_COPY(_except, _what) EXCEPT_THROW_COPY(_except, _what)
+    #define THROWF(_except, ...) EXCEPT_THROWF(_except, __VA_ARGS__)
+    #define THROW_WITH(_except, _type, _value) EXCEPT_THROW_WITH(_except, _type, _value)
+    #define CATCH_PAYLOAD(x, _type, _var) EXCEPT_CATCH_PAYLOAD(x, _type, _var)
+    #define CATCH_ANY_OF(...) EXCEPT_CATCH_ANY_OF(__VA_ARGS__)
+    #define CATCH_RANGE(_lo, _hi) EXCEPT_CATCH_RANGE(_lo, _hi)
+    #define CATCH_CATEGORY(_category) EXCEPT_CATCH_CATEGORY(_category)
     #define FINALLY EXCEPT_FINALLY
+    #define ON_UNWIND(_fn, _arg) EXCEPT_ON_UNWIND(_fn, _arg)
     #define END_TRY EXCEPT_END_TRY
     #define RETHROW EXCEPT_RETHROW
     #define LOAD(...) EXCEPT_LOAD(__VA_ARGS__)
@@ -455,6 +773,7 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
     #define SAVE(...) EXCEPT_SAVE(__VA_ARGS__)
     #define VAR(...) EXCEPT_VAR(__VA_ARGS__)
     #define TERMINATE(status, ...) EXCEPT_TERMINATE(status, __VA_ARGS__)
+    #define STACK_TRACE(stream) EXCEPT_STACK_TRACE(stream)
     #define WHAT EXCEPT_WHAT
 #endif
 
@@ -466,8 +785,9 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
     #warning "ALWAYS_THROWS is already defined. Undefining it."
     #undef ALWAYS_THROWS
 #endif
-#if defined(EXCEPT_SENTINEL_NULL)
+#if defined(EXCEPT_SENTINEL_NULL) || defined(EXCEPT_FORMAT_PRINTF)
     #undef EXCEPT_SENTINEL_NULL
+    #undef EXCEPT_FORMAT_PRINTF
 #endif
 #if defined(EXCEPT_COND_PROB)
     #undef EXCEPT_COND_PROB
@@ -532,8 +852,10 @@ static_assert(EXCEPT_TERM_HANDLER_ARGC <= 8, "EXCEPT_TERM_HANDLER_TYPE_LIST must
 
 #if defined(__GNUC__) || defined(__clang__)
     #define EXCEPT_SENTINEL_NULL(...) __attribute__((__sentinel__(__VA_ARGS__)))
+    #define EXCEPT_FORMAT_PRINTF(_fmt_idx, _first_arg_idx) __attribute__((__format__(__printf__, _fmt_idx, _first_arg_idx)))
 #else
     #define EXCEPT_SENTINEL_NULL(...)
+    #define EXCEPT_FORMAT_PRINTF(_fmt_idx, _first_arg_idx)
 #endif
 
 #if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !(__STDC_VERSION__ >= 202300L) && !defined(__cplusplus)
@@ -580,7 +902,9 @@ typedef enum exC_flags exC_flags_t;
  * @brief Setup the exception handling system.
  * @note This function must be called before any other function of the exception handling system, and before using any of the provided macros.
  * 
- * @param stack_size The number of possible nested `TRY` blocks.
+ * @param stack_size The maximum number of nested `TRY` blocks. Each thread's exception stack starts with
+ *                   `EXCEPT_STACK_INITIAL_SIZE` entries, and grows up to `stack_size` entries. Beyond that, `TRY`
+ *                   throws `EXCEPT_STACK_OVERFLOW` to the enclosing block.
  * @param flags The flags to use.
  * @return 0 on success, non-0 on failure.
  */
@@ -609,6 +933,320 @@ EXCEPT_API void exC_thrd_deinit(void);
  */
 EXCEPT_API void exC_global_deinit(void);
 
+/**
+ * @fn void* exC_frame_alloc(size_t size)
+ * @brief Allocate memory released when the innermost `TRY` block ends, whichever way.
+ * @note Small blocks come from the thread's arena (see `EXCEPT_ARENA_SIZE`), others from `malloc`. Do not free it.
+ *
+ * @param size The size of the memory block, aligned like `malloc` would.
+ * @return The memory block, or NULL if it could not be allocated or if there is no `TRY` block.
+ */
+EXCEPT_API void* exC_frame_alloc(size_t size);
+
+/**
+ * @brief Outcome of `exC_call_result`.
+ * @details
+ * - `code` is the exception thrown by the call, or 0 if it returned normally.
+ * - `what` is its `WHAT` message, or NULL if it returned normally. It stays valid until the thread throws again.
+ */
+typedef struct exC_result
+{
+    EXCEPT_EXCEPTION_TYPE code;
+    const char* what;
+} exC_result_t;
+
+/**
+ * @fn exC_result_t exC_call_result(void (*fn)(void*), void* arg)
+ * @brief Call `fn(arg)`, and return the exception it throws instead of letting it out, e.g. at the boundary of an API
+ *        returning error codes.
+ * @note The thread is set up if it has not been yet. Each call costs a `TRY` block.
+ *
+ * @param fn The function to call.
+ * @param arg Its argument.
+ * @return The exception thrown by `fn` and its message, or `{ 0, NULL }`.
+ */
+EXCEPT_API exC_result_t exC_call_result(void (*fn)(void*), void* arg);
+
+/**
+ * @brief Payload of the exceptions thrown by faults (see `exC_signals_install`).
+ * @details
+ * - `signal` is the signal raised by the fault (SIGSEGV, SIGFPE or SIGBUS).
+ * - `code` is its `si_code`, e.g. `SEGV_MAPERR` or `FPE_INTDIV`.
+ * - `address` is its `si_addr` : the faulting memory access, or the faulting instruction for SIGFPE.
+ */
+typedef struct exC_fault
+{
+    int signal;
+    int code;
+    void* address;
+} exC_fault_t;
+
+/**
+ * @fn int exC_signals_install(void)
+ * @brief Throw the faults of the calling thread (SIGSEGV, SIGFPE and SIGBUS) as exceptions.
+ * @note The handlers are installed for the whole process, and run on an alternate stack of `EXCEPT_SIGNAL_STACK_SIZE`
+ *       bytes set up for each thread calling it (freed by `exC_thrd_deinit`), so that stack overflows are caught too.
+ *       Faults are thrown as `EXCEPT_SEGMENTATION_FAULT`, `EXCEPT_ARITHMETIC_FAULT` and `EXCEPT_BUS_FAULT`, with an
+ *       `exC_fault_t` payload. A fault outside of any `TRY` block goes to the action the handler replaced. Only
+ *       supported on Linux, macOS and FreeBSD.
+ *
+ * @return 0 on success, -1 if thread setup has not been done, the alternate stack could not be set up, or faults can
+ *         not be handled on this platform.
+ */
+EXCEPT_API int exC_signals_install(void);
+
+/**
+ * @fn void exC_signals_uninstall(void)
+ * @brief Restore the handlers replaced by `exC_signals_install`.
+ */
+EXCEPT_API void exC_signals_uninstall(void);
+
+/**
+ * @brief A callback run by `exC_run_batch`.
+ * @details
+ * - `fn` is called with `arg`.
+ * - `on_error`, if not NULL, is called with `arg` and the exception if `fn` throws. It runs like a `CATCH` clause :
+ *   `WHAT` and `exC_capture_current` can be used, and an exception it throws leaves the batch.
+ */
+typedef struct exC_callback
+{
+    void (*fn)(void* arg);
+    void (*on_error)(void* arg, EXCEPT_EXCEPTION_TYPE exception);
+    void* arg;
+} exC_callback_t;
+
+/**
+ * @fn size_t exC_run_batch(const exC_callback_t* callbacks, size_t count)
+ * @brief Run callbacks in order, within a single `TRY` block : an exception only fails the callback that threw it.
+ * @note The block is set up once for the whole batch, e.g. once per iteration of an event loop. What a callback leaves
+ *       in the block (payloads, frame allocations, `ON_UNWIND` cleanups) is released when it returns or throws.
+ *
+ * @param callbacks The callbacks to run.
+ * @param count The number of callbacks.
+ * @return The number of callbacks that threw.
+ */
+EXCEPT_API size_t exC_run_batch(const exC_callback_t* callbacks, size_t count);
+
+/**
+ * @brief An exception taken out of the thread that caught it, to be rethrown by another one (see `exC_capture_current`).
+ */
+typedef struct exC_captured exC_captured_t;
+
+/**
+ * @fn exC_captured_t* exC_capture_current(void)
+ * @brief Copy the exception being handled by a `CATCH` clause : its code, message, payload and stack trace.
+ * @note The copy belongs to no thread : pass it to any thread, e.g. through an atomic pointer, and give it to
+ *       `exC_rethrow_captured` or `exC_captured_free` there.
+ *
+ * @return The copy, or NULL if there is no exception being handled or if it could not be allocated.
+ */
+EXCEPT_API exC_captured_t* exC_capture_current(void);
+
+/**
+ * @fn void exC_rethrow_captured(exC_captured_t* captured)
+ * @brief Throw a captured exception in the calling thread, as if it was thrown again where it was first thrown.
+ * @note `captured` is freed.
+ *
+ * @param captured The exception, from `exC_capture_current`.
+ */
+EXCEPT_NORETURN
+EXCEPT_API void exC_rethrow_captured(exC_captured_t* captured);
+
+/**
+ * @fn EXCEPT_EXCEPTION_TYPE exC_captured_exception(const exC_captured_t* captured)
+ * @brief Get the code of a captured exception (0 for NULL).
+ */
+EXCEPT_API EXCEPT_EXCEPTION_TYPE exC_captured_exception(const exC_captured_t* captured);
+
+/**
+ * @fn const char* exC_captured_what(const exC_captured_t* captured)
+ * @brief Get the message of a captured exception, valid until it is freed or rethrown.
+ */
+EXCEPT_API const char* exC_captured_what(const exC_captured_t* captured);
+
+/**
+ * @fn void exC_captured_free(exC_captured_t* captured)
+ * @brief Free a captured exception that is not rethrown.
+ */
+EXCEPT_API void exC_captured_free(exC_captured_t* captured);
+
+/**
+ * @brief Tasks run by a pool of threads, until the first one throws (see `exC_task_group_create`).
+ */
+typedef struct exC_task_group exC_task_group_t;
+
+/**
+ * @fn exC_task_group_t* exC_task_group_create(size_t workers)
+ * @brief Start a group of `workers` threads, which set up their exception context themselves, to run tasks.
+ * @note Threads are not created with `EXCEPT_ONE_THREAD` or `EXCEPT_USE_CUSTOM_THREADS` : tasks are then run by
+ *       `exC_task_group_wait`.
+ *
+ * @param workers The number of threads (the one waiting for the group runs tasks too).
+ * @return The group, or NULL if it could not be allocated.
+ */
+EXCEPT_API exC_task_group_t* exC_task_group_create(size_t workers);
+
+/**
+ * @fn int exC_task_group_run(exC_task_group_t* group, void (*fn)(void*), void* arg)
+ * @brief Queue a task, run as `fn(arg)` by any thread of the group. Tasks may queue other tasks.
+ * @note Tasks queued once a task has thrown are not run (see `exC_task_group_cancelled`).
+ *
+ * @return 0 on success, non-0 on failure.
+ */
+EXCEPT_API int exC_task_group_run(exC_task_group_t* group, void (*fn)(void*), void* arg);
+
+/**
+ * @fn int exC_task_group_cancelled(const exC_task_group_t* group)
+ * @brief Whether a task of the group has thrown, so that long tasks can stop early.
+ */
+EXCEPT_API int exC_task_group_cancelled(const exC_task_group_t* group);
+
+/**
+ * @fn void exC_task_group_wait(exC_task_group_t* group)
+ * @brief Run tasks until all of them have ended, stop the threads and free the group. Then, if a task has thrown,
+ *        throw its exception (the first one, if several tasks have thrown) in the calling thread.
+ */
+EXCEPT_API void exC_task_group_wait(exC_task_group_t* group);
+
+/**
+ * @brief Counts of one exception code (see `exC_stats_snapshot`).
+ * @details
+ * - `thrown` counts `THROW` (and `THROW_COPY`, `THROWF`, `THROW_WITH`), `rethrown` counts `THROW()`.
+ * - `caught` counts the `CATCH` clauses run.
+ * - `terminated` counts the exceptions that reached no `TRY` block.
+ */
+typedef struct exC_code_stats
+{
+    EXCEPT_EXCEPTION_TYPE code;
+    unsigned long long thrown;
+    unsigned long long caught;
+    unsigned long long rethrown;
+    unsigned long long terminated;
+} exC_code_stats_t;
+
+/**
+ * @brief A `THROW` and the number of times it threw (see `exC_stats_snapshot`).
+ */
+typedef struct exC_site_stats
+{
+    const char* file;
+    int line;
+    // Code of its first throw
+    EXCEPT_EXCEPTION_TYPE code;
+    unsigned long long thrown;
+} exC_site_stats_t;
+
+/**
+ * @brief Exception statistics of every thread.
+ * @details
+ * - `codes` are the `code_count` codes seen, most thrown first.
+ * - `top_sites` are the `site_count` sites that threw the most, most thrown first.
+ * - `untracked` counts the events whose code or site did not fit in the tables of their thread (or of the snapshot).
+ */
+typedef struct exC_stats
+{
+    size_t code_count;
+    exC_code_stats_t codes[EXCEPT_STATS_CODES];
+    size_t site_count;
+    exC_site_stats_t top_sites[EXCEPT_STATS_TOP_SITES];
+    unsigned long long untracked;
+} exC_stats_t;
+
+/**
+ * @fn int exC_stats_snapshot(exC_stats_t* stats)
+ * @brief Add up the exception statistics of every thread, including the ones that ended.
+ * @note Only counted when exCept is built with `EXCEPT_STATS`. Can be called from any thread, while others throw.
+ *
+ * @param stats Where to store them.
+ * @return 0 on success, non-0 on failure (or without `EXCEPT_STATS`).
+ */
+EXCEPT_API int exC_stats_snapshot(exC_stats_t* stats);
+
+/**
+ * @brief A sampled throw (see `exC_sample_every`).
+ * @details
+ * - `time` is the time of the throw, in nanoseconds since the epoch.
+ * - `thread` numbers the threads from 1, in the order they called `exC_thrd_setup`.
+ * - `frames` are the `depth` return addresses of the throw, innermost first (see `exC_stack_trace`).
+ */
+typedef struct exC_sample
+{
+    EXCEPT_EXCEPTION_TYPE code;
+    unsigned long long time;
+    unsigned long thread;
+    size_t depth;
+    void* frames[EXCEPT_SAMPLE_DEPTH];
+} exC_sample_t;
+
+/**
+ * @fn int exC_sample_every(unsigned long throws)
+ * @brief Sample one throw out of `throws` in each thread, from now on.
+ * @note Only sampled when exCept is built with `EXCEPT_SAMPLING`. Can be called from any thread.
+ *
+ * @param throws The sampling period, 0 to stop sampling.
+ * @return 0 on success, non-0 on failure (or without `EXCEPT_SAMPLING`).
+ */
+EXCEPT_API int exC_sample_every(unsigned long throws);
+
+/**
+ * @fn int exC_sample_rate(double per_second)
+ * @brief Sample about `per_second` throws per second in each thread (fewer if it throws less), from now on.
+ * @note The sampling period of each thread adapts to how often it throws, at every sample.
+ *
+ * @param per_second The target rate, 0 to stop sampling.
+ * @return 0 on success, non-0 on failure (or without `EXCEPT_SAMPLING`).
+ */
+EXCEPT_API int exC_sample_rate(double per_second);
+
+/**
+ * @fn size_t exC_samples_drain(exC_sample_t* samples, size_t max)
+ * @brief Move the samples of every thread, including the ones that ended, to `samples`.
+ * @note Can be called from any thread, while others throw.
+ *
+ * @param samples Where to store them, oldest first for each thread.
+ * @param max The number of samples that fit in `samples`.
+ * @return The number of samples stored.
+ */
+EXCEPT_API size_t exC_samples_drain(exC_sample_t* samples, size_t max);
+
+/**
+ * @fn int exC_samples_write_collapsed(FILE* stream)
+ * @brief Drain the samples and write them as collapsed stacks, one line per distinct stack and code, for flame graph
+ *        tools (like `flamegraph.pl`).
+ *
+ * @param stream Where to write them.
+ * @return 0 on success, non-0 on failure (or without `EXCEPT_SAMPLING`).
+ */
+EXCEPT_API int exC_samples_write_collapsed(FILE* stream);
+
+/**
+ * @fn size_t exC_stack_trace(void* const** frames)
+ * @brief Get the return addresses captured when the last exception of the calling thread was thrown.
+ * @note Only captured when exCept is built with `EXCEPT_CAPTURE_STACK_TRACE`. Nothing is symbolized : see
+ *       `exC_print_stack_trace`.
+ *
+ * @param frames Set to the addresses, innermost first. They stay valid until the next throw.
+ * @return The number of addresses (0 if none were captured).
+ */
+EXCEPT_API size_t exC_stack_trace(void* const** frames);
+
+/**
+ * @fn void exC_print_stack_trace(FILE* stream)
+ * @brief Print the stack trace of the last exception of the calling thread, symbolized with `dladdr` when available.
+ *
+ * @param stream Where to print it.
+ */
+EXCEPT_API void exC_print_stack_trace(FILE* stream);
+
+/**
+ * @fn void exC_print_flight_recorder(FILE* stream)
+ * @brief Print the last events (throws, catches, rethrows) of every thread, including the ones that ended.
+ * @note Only recorded when exCept is built with `EXCEPT_FLIGHT_RECORDER`, and printed by `exC_terminate` too.
+ *
+ * @param stream Where to print them.
+ */
+EXCEPT_API void exC_print_flight_recorder(FILE* stream);
+
 /**
  * @fn int exC_set_term_handler(term_handler_t handler)
  * @brief Set the termination handler.
@@ -624,14 +1262,136 @@ EXCEPT_API                          int  exC_is_global_setup_done(void);
 EXCEPT_API                          int  exC_is_thread_setup_done(void);
 EXCEPT_API                          int  exC_is_stack_size_set(void);
 EXCEPT_API                          int  exC_is_stack_created(void);
-EXCEPT_API                          int  exC_push_stack(jmp_buf* env);
+EXCEPT_API                          int  exC_push_stack(exC_jmp_buf* env);
 EXCEPT_API                         void  exC_pop_stack(void);
 EXCEPT_NORETURN EXCEPT_SENTINEL_NULL(0)
 EXCEPT_API                         void  exC_unwind(EXCEPT_EXCEPTION_TYPE except, ...);
-EXCEPT_API                         char* exC_last_exception_what(void);
+EXCEPT_NORETURN
+EXCEPT_API                         void  exC_unwind_static(EXCEPT_EXCEPTION_TYPE except, const char* what);
+EXCEPT_NORETURN EXCEPT_FORMAT_PRINTF(3, 4)
+EXCEPT_API                         void  exC_unwind_fmt(EXCEPT_EXCEPTION_TYPE except, int fmt_is_static, const char* fmt, ...);
+EXCEPT_NORETURN
+EXCEPT_API                         void  exC_unwind_payload(EXCEPT_EXCEPTION_TYPE except, const void* payload, size_t size);
+EXCEPT_NORETURN
+EXCEPT_API                         void  exC_rethrow(void);
+EXCEPT_API                   const char* exC_last_exception_what(void);
 EXCEPT_API         EXCEPT_EXCEPTION_TYPE exC_last_exception(void);
+EXCEPT_API                   const void* exC_last_payload(size_t size);
+EXCEPT_API                          int  exC_enter_finally(void);
+EXCEPT_API                         void  exC_on_unwind(void (*fn)(void*), void* arg);
+EXCEPT_API                         void  exC_throw_site(const char* file, int line);
+EXCEPT_API                         void  exC_on_catch(void);
 EXCEPT_NORETURN
 EXCEPT_API                         void  exC_terminate(int status, ...);
+EXCEPT_API extern              max_align_t  exC_noexcept_marker;
+
+/**
+ * @brief Hot part of the exception context of a thread.
+ * @note Owned by the library. Only read or modify it through the provided functions and macros.
+ * @details
+ * It is the beginning of a single allocation, aligned on a cache line, which also holds the initial exception stack
+ * (next cache line), the arguments captured by `THROWF`, and the `WHAT` buffer (last).
+ * - `stack` is the `jmp_buf` stack of the thread. The low bits of each entry hold the state of its `TRY` block, e.g.
+ *   whether its `CATCH` clause is running, so that a `THROW` from a `CATCH` runs the `FINALLY` clause and then reaches
+ *   the outer block.
+ * - `top` is the number of entries currently pushed.
+ * - `size` is the current capacity of `stack` (it grows up to the size passed to `exC_global_setup`).
+ * - `last_exception` is the last exception thrown.
+ * - `what` is its message, or NULL if it still has to be formatted (see `THROWF`).
+ * - `payload` is the payload record of the last exception (see `THROW_WITH`), or NULL if it has none.
+ * - `records` is the innermost record of the arena (payloads, cleanups), or NULL if it is empty.
+ */
+typedef struct exC_context
+{
+    exC_jmp_buf** stack;
+    size_t top;
+    size_t size;
+    EXCEPT_EXCEPTION_TYPE last_exception;
+    const char* what;
+    void* payload;
+    void* records;
+} exC_context_t;
+
+/**
+ * @fn exC_context_t* exC_get_context(void)
+ * @brief Get the exception context of the calling thread.
+ * @note The pointer stays valid until the thread calls `exC_thrd_deinit` or exits, so it can be cached.
+ * 
+ * @return The context of the calling thread, or NULL if `exC_thrd_setup` has not been called.
+ */
+EXCEPT_API exC_context_t* exC_get_context(void);
+
+/**
+ * @fn exC_context_t* exC_ctx_create(void)
+ * @brief Create an exception context bound to no thread, e.g. for a coroutine or a green thread.
+ * @note Its stack traces and samples are empty, since the bounds of the stack it runs on are not known.
+ * 
+ * @return The new context, or NULL if global setup has not been done or if it can not be allocated.
+ */
+EXCEPT_API exC_context_t* exC_ctx_create(void);
+
+/**
+ * @fn exC_context_t* exC_ctx_switch(exC_context_t* ctx)
+ * @brief Make `ctx` the exception context of the calling thread, until the next switch.
+ * @note Meant to be called by fiber schedulers on every swap : a fiber may yield within a `TRY` block, which stays on
+ *       its context until it is switched back to. The context set up by `exC_thrd_setup` still belongs to the thread,
+ *       and is freed by `exC_thrd_deinit`.
+ * 
+ * @param ctx The context to switch to (created by `exC_ctx_create`, or returned by a previous switch), or NULL.
+ * @return The previous context of the calling thread.
+ */
+EXCEPT_API exC_context_t* exC_ctx_switch(exC_context_t* ctx);
+
+/**
+ * @fn void exC_ctx_destroy(exC_context_t* ctx)
+ * @brief Free a context created by `exC_ctx_create`.
+ * @note It must not be the current context of any thread.
+ * 
+ * @param ctx The context to free, or NULL.
+ */
+EXCEPT_API void exC_ctx_destroy(exC_context_t* ctx);
+
+#if defined(EXCEPT_CONTEXT)
+    #undef EXCEPT_CONTEXT
+#endif
+#if defined(EXCEPT_USE_CUSTOM_THREADS) && !defined(EXCEPT_ONE_THREAD)
+    // There is no thread-local storage to cache it, so it is looked up in the context map
+    #define EXCEPT_CONTEXT() exC_get_context()
+#else
+    EXCEPT_API extern EXCEPT_THREAD_LOCAL exC_context_t* exC_current_context;
+    #define EXCEPT_CONTEXT() exC_current_context
+#endif
+
+#if defined(EXCEPT_INLINE_FAST_PATH)
+static inline int exC_inline_push_stack(exC_jmp_buf* env)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    // Full checks and error reporting are left to the library
+    if (EXCEPT_COND_PROB(ctx->top >= ctx->size, 0, 0.999))
+        return exC_push_stack(env);
+    ctx->stack[ctx->top++] = env;
+    return 0;
+}
+
+static inline void exC_inline_pop_stack(void)
+{
+    exC_context_t* ctx = EXCEPT_CONTEXT();
+    // Payloads may have to be released, or cleanups run
+    if (ctx->records != NULL)
+        exC_pop_stack();
+    else if (ctx->top != 0)
+        --ctx->top;
+}
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+// Cleanup of the guard declared by `NOEXCEPT`, popping its marker
+static inline void exC_noexcept_end(char* guard)
+{
+    (void) guard;
+    EXCEPT_POP_STACK();
+}
+#endif
 
 #endif // EXCEPT_H
 
@@ -641,6 +1401,7 @@ EXCEPT_API                         void  exC_terminate(int status, ...);
 
 #undef EXCEPT_COND_PROB
 #undef EXCEPT_SENTINEL_NULL
+#undef EXCEPT_FORMAT_PRINTF
 #undef EXCEPT_NORETURN
 #undef EXCEPT_API
 #undef STACK_ALLOC
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define FATAL_EXCEPTION 2
+
+#define REQUESTS 8
+
+struct request
+{
+    int id;
+    int served;
+    int failed;
+};
+
+static int cleanups = 0;
+
+static void cleanup(void* arg)
+{
+    (void)arg;
+    cleanups++;
+}
+
+// Odd requests fail, from a nested block for some of them
+static void serve(void* arg)
+{
+    struct request* request = arg;
+    check(exC_frame_alloc(16) != NULL, "frame allocation in a callback", __LINE__);
+    ON_UNWIND(cleanup, NULL);
+    if (request->id % 4 == 3)
+    {
+        TRY
+        {
+            THROWF(IO_EXCEPTION, "request %d", request->id);
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            THROW();
+        }
+        END_TRY;
+    }
+    if (request->id % 2 == 1)
+        THROWF(IO_EXCEPTION, "request %d", request->id);
+    request->served = 1;
+}
+
+static void fail(void* arg, EXCEPT_EXCEPTION_TYPE exception)
+{
+    struct request* request = arg;
+    char expected[32];
+    snprintf(expected, sizeof(expected), "request %d", request->id);
+    request->failed = exception == IO_EXCEPTION && strcmp(WHAT, expected) == 0;
+}
+
+static void fail_fatally(void* arg, EXCEPT_EXCEPTION_TYPE exception)
+{
+    (void)arg;
+    THROW(FATAL_EXCEPTION, exception == IO_EXCEPTION ? "handler" : "unexpected");
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    // Each failure only fails its own request
+    struct request requests[REQUESTS];
+    exC_callback_t callbacks[REQUESTS];
+    for (int i = 0; i < REQUESTS; i++)
+    {
+        requests[i] = (struct request) { .id = i };
+        callbacks[i] = (exC_callback_t) { .fn = serve, .on_error = fail, .arg = &requests[i] };
+    }
+    check(exC_run_batch(callbacks, REQUESTS) == REQUESTS / 2, "failed callbacks", __LINE__);
+    for (int i = 0; i < REQUESTS; i++)
+        check(requests[i].served == (i % 2 == 0) && requests[i].failed == (i % 2 == 1), "request outcome", __LINE__);
+    check(cleanups == REQUESTS, "cleanups run after each callback", __LINE__);
+    check(EXCEPT_CONTEXT()->top == 0 && EXCEPT_CONTEXT()->records == NULL, "block ended", __LINE__);
+
+    // Failures without a handler are just counted
+    callbacks[1].on_error = NULL;
+    check(exC_run_batch(callbacks, 2) == 1, "failure without handler", __LINE__);
+
+    // An exception thrown by a handler leaves the batch
+    callbacks[1].on_error = fail_fatally;
+    requests[2].served = 0;
+    volatile int caught = 0;
+    TRY
+    {
+        exC_run_batch(callbacks, 3);
+    }
+    CATCH(FATAL_EXCEPTION)
+    {
+        caught = strcmp(WHAT, "handler") == 0;
+    }
+    END_TRY;
+    check(caught && !requests[2].served, "exception of the handler", __LINE__);
+    check(EXCEPT_CONTEXT()->top == 0, "batch block popped", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
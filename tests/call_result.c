@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define PARSE_EXCEPTION 2
+
+struct job
+{
+    int id;
+    int done;
+};
+
+static void run(void* arg)
+{
+    struct job* job = arg;
+    if (job->id < 0)
+        THROWF(IO_EXCEPTION, "job %d failed", job->id);
+    job->done = 1;
+}
+
+// Calls made from a call have their own block
+static void nested(void* arg)
+{
+    exC_result_t result = exC_call_result(run, arg);
+    check(result.code == IO_EXCEPTION && strcmp(result.what, "job -2 failed") == 0, "nested call", __LINE__);
+    THROW(PARSE_EXCEPTION, "outer");
+}
+
+// The plain error-code API built on it
+static int api_run(int id)
+{
+    struct job job = { .id = id };
+    return (int) exC_call_result(run, &job).code;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+
+    // The calling thread is set up if needed
+    struct job job = { .id = 1 };
+    exC_result_t result = exC_call_result(run, &job);
+    check(result.code == 0 && result.what == NULL && job.done, "call returned", __LINE__);
+    check(exC_is_thread_setup_done(), "thread set up", __LINE__);
+
+    job.id = -1;
+    result = exC_call_result(run, &job);
+    check(result.code == IO_EXCEPTION && strcmp(result.what, "job -1 failed") == 0, "exception returned", __LINE__);
+    check(EXCEPT_CONTEXT()->top == 0, "block popped", __LINE__);
+
+    job.id = -2;
+    result = exC_call_result(nested, &job);
+    check(result.code == PARSE_EXCEPTION && strcmp(result.what, "outer") == 0, "outer call", __LINE__);
+
+    check(api_run(3) == 0 && api_run(-3) == IO_EXCEPTION, "error codes", __LINE__);
+
+    // Within a `TRY` block, exceptions do not reach it
+    volatile int caught = 0;
+    TRY
+    {
+        result = exC_call_result(run, &job);
+    }
+    CATCH()
+    {
+        caught = 1;
+    }
+    END_TRY;
+    check(!caught && result.code == IO_EXCEPTION, "enclosing block untouched", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
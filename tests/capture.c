@@ -0,0 +1,181 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(EXCEPT_ONE_THREAD)
+    #include <threads.h>
+#endif
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define PARSE_EXCEPTION 2
+
+#define WORKERS 4
+
+// A literal of 4000 characters, longer than the `WHAT` buffer
+#define TIMES_10(_s) _s _s _s _s _s _s _s _s _s _s
+#define LONG_WHAT TIMES_10(TIMES_10(TIMES_10("abcd")))
+
+struct parse_error
+{
+    int line;
+    int column;
+};
+
+// Each worker leaves its exception there, for `main` to rethrow it
+static _Atomic(exC_captured_t*) slots[WORKERS];
+
+static void work(int id)
+{
+    TRY
+    {
+        if (id % 2 == 0)
+            THROWF(IO_EXCEPTION, "worker %d could not read", id);
+        THROW_WITH(PARSE_EXCEPTION, struct parse_error, ((struct parse_error) { .line = id, .column = 7 }));
+    }
+    CATCH()
+    {
+        atomic_store_explicit(&slots[id], exC_capture_current(), memory_order_release);
+    }
+    END_TRY;
+}
+
+#if !defined(EXCEPT_ONE_THREAD)
+static int worker(void* arg)
+{
+    exC_thrd_setup();
+    work(*(int*) arg);
+    exC_thrd_deinit();
+    return 0;
+}
+#endif
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    check(exC_capture_current() == NULL, "nothing to capture", __LINE__);
+
+#if !defined(EXCEPT_ONE_THREAD)
+    int ids[WORKERS];
+    thrd_t threads[WORKERS];
+    int started[WORKERS];
+    for (int i = 0; i < WORKERS; i++)
+    {
+        ids[i] = i;
+        started[i] = thrd_create(&threads[i], worker, &ids[i]) == thrd_success;
+        if (!started[i])
+            work(i);
+    }
+    for (int i = 0; i < WORKERS; i++)
+    {
+        if (started[i])
+            thrd_join(threads[i], NULL);
+    }
+#else
+    for (int i = 0; i < WORKERS; i++)
+        work(i);
+#endif
+
+    for (int i = 0; i < WORKERS; i++)
+    {
+        exC_captured_t* captured = atomic_load_explicit(&slots[i], memory_order_acquire);
+        check(captured != NULL, "captured", __LINE__);
+        if (captured == NULL)
+            continue;
+        volatile int caught = 0;
+        char expected[64];
+        snprintf(expected, sizeof(expected), "worker %d could not read", i);
+        TRY
+        {
+            exC_rethrow_captured(captured);
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            caught = i % 2 == 0 && strcmp(WHAT, expected) == 0;
+        }
+        CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, error)
+        {
+            caught = i % 2 == 1 && error != NULL && error->line == i && error->column == 7;
+        }
+        END_TRY;
+        check(caught, "rethrown in another thread", __LINE__);
+    }
+
+    // Captured exceptions can be looked at, and rethrown again
+    TRY
+    {
+        THROW(IO_EXCEPTION, "disk full");
+    }
+    CATCH()
+    {
+        exC_captured_t* captured = exC_capture_current();
+        check(exC_captured_exception(captured) == IO_EXCEPTION && strcmp(exC_captured_what(captured), "disk full") == 0,
+              "captured exception", __LINE__);
+        exC_captured_free(captured);
+    }
+    END_TRY;
+
+    volatile int caught = 0;
+    TRY
+    {
+        TRY
+        {
+            THROWF(PARSE_EXCEPTION, "line %d", 12);
+        }
+        CATCH()
+        {
+            exC_captured_t* captured = exC_capture_current();
+            TRY
+            {
+                THROW(IO_EXCEPTION, "while handling");
+            }
+            CATCH()
+            {
+            }
+            END_TRY;
+            exC_rethrow_captured(captured);
+        }
+        END_TRY;
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        caught = strcmp(WHAT, "line 12") == 0;
+    }
+    END_TRY;
+    check(caught, "rethrown from a catch clause", __LINE__);
+
+    // Messages stored by address are captured whole, and truncated to the `WHAT` buffer when rethrown
+    exC_captured_t* volatile captured = NULL;
+    TRY
+    {
+        THROW(IO_EXCEPTION, LONG_WHAT);
+    }
+    CATCH()
+    {
+        captured = exC_capture_current();
+    }
+    END_TRY;
+    check(strcmp(exC_captured_what(captured), LONG_WHAT) == 0, "long message captured", __LINE__);
+    caught = 0;
+    TRY
+    {
+        exC_rethrow_captured(captured);
+    }
+    CATCH(IO_EXCEPTION)
+    {
+        size_t length = strlen(WHAT);
+        caught = length > 0 && length < strlen(LONG_WHAT) && strncmp(WHAT, LONG_WHAT, length) == 0;
+    }
+    END_TRY;
+    check(caught, "long message rethrown", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_CATEGORY 1
+#define PARSE_CATEGORY 2
+
+#define FILE_NOT_FOUND EXCEPT_MAKE_CODE(IO_CATEGORY, 1)
+#define PERMISSION_DENIED EXCEPT_MAKE_CODE(IO_CATEGORY, 2)
+#define UNEXPECTED_TOKEN EXCEPT_MAKE_CODE(PARSE_CATEGORY, 1)
+
+// Returns which clause caught `except`
+static int dispatch(EXCEPT_EXCEPTION_TYPE except)
+{
+    volatile int clause = 0;
+    TRY
+    {
+        THROW(except);
+    }
+    CATCH_ANY_OF(3, 5, 7)
+    {
+        clause = 1;
+    }
+    CATCH_RANGE(10, 19)
+    {
+        clause = 2;
+    }
+    CATCH_CATEGORY(IO_CATEGORY)
+    {
+        clause = 3;
+    }
+    CATCH_ANY_OF(UNEXPECTED_TOKEN)
+    {
+        clause = 4;
+    }
+    CATCH(e)
+    {
+        clause = 5;
+        (void)e;
+    }
+    END_TRY;
+    return clause;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    check(dispatch(3) == 1 && dispatch(5) == 1 && dispatch(7) == 1, "CATCH_ANY_OF", __LINE__);
+    check(dispatch(4) == 5, "CATCH_ANY_OF caught a code it does not list", __LINE__);
+    check(dispatch(10) == 2 && dispatch(15) == 2 && dispatch(19) == 2, "CATCH_RANGE", __LINE__);
+    check(dispatch(9) == 5 && dispatch(20) == 5, "CATCH_RANGE caught a code out of range", __LINE__);
+    check(dispatch(FILE_NOT_FOUND) == 3 && dispatch(PERMISSION_DENIED) == 3, "CATCH_CATEGORY", __LINE__);
+    check(dispatch(EXCEPT_MAKE_CODE(IO_CATEGORY, EXCEPT_CATEGORY_MAX_CODE)) == 3, "CATCH_CATEGORY upper bound", __LINE__);
+    check(dispatch(EXCEPT_MAKE_CODE(IO_CATEGORY + 1, 2)) == 5, "CATCH_CATEGORY caught another category", __LINE__);
+    check(dispatch(UNEXPECTED_TOKEN) == 4, "CATCH_ANY_OF with a category code", __LINE__);
+    check(EXCEPT_CATEGORY_OF(UNEXPECTED_TOKEN) == PARSE_CATEGORY, "EXCEPT_CATEGORY_OF", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
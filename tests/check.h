@@ -0,0 +1,30 @@
+#ifndef EXCEPT_TESTS_CHECK_H
+#define EXCEPT_TESTS_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Checks which failed so far
+static int failures = 0;
+
+static inline void check(int condition, const char* what, int line)
+{
+    if (!condition)
+    {
+        fprintf(stderr, "line %d: %s\n", line, what);
+        failures++;
+    }
+}
+
+// Exit status of the test, reporting the number of failed checks
+static inline int check_status(void)
+{
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d failure(s)\n", failures);
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+#endif // EXCEPT_TESTS_CHECK_H
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+    #include <ucontext.h>
+#endif
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define PARSE_EXCEPTION 2
+
+#define FIBERS 2
+#define FIBER_STACK_SIZE (64 * 1024)
+
+#if defined(__linux__)
+static ucontext_t scheduler;
+static ucontext_t fibers[FIBERS];
+static exC_context_t* contexts[FIBERS];
+static int caught[FIBERS];
+
+// Back to the scheduler, which switches exception contexts
+static void yield(int id)
+{
+    swapcontext(&fibers[id], &scheduler);
+}
+
+static void fiber(int id)
+{
+    TRY
+    {
+        TRY
+        {
+            // The other fiber runs its own `TRY` blocks meanwhile
+            yield(id);
+            THROWF(id == 0 ? IO_EXCEPTION : PARSE_EXCEPTION, "fiber %d", id);
+        }
+        CATCH()
+        {
+            THROW();
+        }
+        FINALLY
+        {
+            yield(id);
+        }
+        END_TRY;
+    }
+    CATCH()
+    {
+        char expected[16];
+        snprintf(expected, sizeof(expected), "fiber %d", id);
+        caught[id] = exC_last_exception() == (id == 0 ? IO_EXCEPTION : PARSE_EXCEPTION) && strcmp(WHAT, expected) == 0;
+    }
+    END_TRY;
+}
+
+static void run_fibers(void)
+{
+    static char stacks[FIBERS][FIBER_STACK_SIZE];
+    for (int i = 0; i < FIBERS; i++)
+    {
+        contexts[i] = exC_ctx_create();
+        check(contexts[i] != NULL, "context created", __LINE__);
+        getcontext(&fibers[i]);
+        fibers[i].uc_stack.ss_sp = stacks[i];
+        fibers[i].uc_stack.ss_size = FIBER_STACK_SIZE;
+        fibers[i].uc_link = &scheduler;
+        makecontext(&fibers[i], (void (*)(void)) fiber, 1, i);
+    }
+    // Round robin, until both fibers have returned (3 swaps each)
+    exC_context_t* own = EXCEPT_CONTEXT();
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < FIBERS; i++)
+        {
+            exC_context_t* previous = exC_ctx_switch(contexts[i]);
+            swapcontext(&scheduler, &fibers[i]);
+            check(exC_ctx_switch(previous) == contexts[i], "switched back", __LINE__);
+        }
+    }
+    check(EXCEPT_CONTEXT() == own, "own context restored", __LINE__);
+    for (int i = 0; i < FIBERS; i++)
+    {
+        check(caught[i], "each fiber catches its own exception", __LINE__);
+        exC_ctx_destroy(contexts[i]);
+    }
+}
+#endif
+
+int main(void)
+{
+    check(exC_ctx_create() == NULL, "no context before global setup", __LINE__);
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    // Each context has its own exception stack and last exception
+    exC_context_t* other = exC_ctx_create();
+    check(other != NULL, "context created", __LINE__);
+    volatile int caught_outer = 0;
+    TRY
+    {
+        exC_context_t* own = exC_ctx_switch(other);
+        check(own != NULL && EXCEPT_CONTEXT() == other && exC_is_thread_setup_done(), "switched", __LINE__);
+        volatile int caught_inner = 0;
+        TRY
+        {
+            THROW(IO_EXCEPTION, "inner");
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            caught_inner = strcmp(WHAT, "inner") == 0;
+        }
+        END_TRY;
+        check(caught_inner && other->top == 0, "caught in the other context", __LINE__);
+        exC_ctx_switch(own);
+        check(EXCEPT_CONTEXT()->top == 1, "outer block kept", __LINE__);
+        THROW(PARSE_EXCEPTION, "outer");
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        caught_outer = strcmp(WHAT, "outer") == 0;
+    }
+    END_TRY;
+    check(caught_outer, "caught in the own context", __LINE__);
+    check(other->last_exception == IO_EXCEPTION, "last exception of the other context", __LINE__);
+    exC_ctx_destroy(other);
+
+#if defined(__linux__)
+    run_fibers();
+#endif
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
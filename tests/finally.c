@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define PARSE_EXCEPTION 2
+
+// Cleanups record the order they ran in
+static char order[16];
+static size_t order_len = 0;
+
+static void record(void* arg)
+{
+    if (order_len < sizeof(order) - 1)
+        order[order_len++] = *(const char*) arg;
+}
+
+static void reset_order(void)
+{
+    order_len = 0;
+    memset(order, 0, sizeof(order));
+}
+
+// Runs one block, throwing `thrown` from its `TRY` clause and `rethrown` from its `CATCH` clause (0 for none)
+static int run_block(int thrown, int rethrown)
+{
+    volatile int finally_runs = 0;
+    TRY
+    {
+        if (thrown != 0)
+            THROW(thrown, "from try");
+    }
+    CATCH(IO_EXCEPTION)
+    {
+        if (rethrown != 0)
+            THROW(rethrown, "from catch");
+    }
+    FINALLY
+    {
+        ++finally_runs;
+    }
+    END_TRY;
+    return finally_runs;
+}
+
+static void open_and_throw(void)
+{
+    TRY
+    {
+        ON_UNWIND(record, "a");
+        ON_UNWIND(record, "b");
+        THROW(IO_EXCEPTION);
+    }
+    FINALLY
+    {
+        record("f");
+    }
+    END_TRY;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    // `FINALLY` runs once on every path
+    check(run_block(0, 0) == 1, "finally on normal exit", __LINE__);
+    check(run_block(IO_EXCEPTION, 0) == 1, "finally after catch", __LINE__);
+    check(run_block(PARSE_EXCEPTION, 0) == 1, "finally without a matching catch", __LINE__);
+
+    // An exception leaving a `CATCH` clause runs `FINALLY`, then reaches the outer block with its message
+    volatile int caught = 0;
+    TRY
+    {
+        run_block(IO_EXCEPTION, PARSE_EXCEPTION);
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        caught = strcmp(WHAT, "from catch") == 0;
+    }
+    END_TRY;
+    check(caught, "exception thrown from catch", __LINE__);
+
+    // The `FINALLY` clause may handle exceptions of its own while another one goes through
+    caught = 0;
+    TRY
+    {
+        TRY
+        {
+            THROW(IO_EXCEPTION);
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            THROWF(PARSE_EXCEPTION, "line %d", 12);
+        }
+        FINALLY
+        {
+            TRY
+            {
+                THROW_COPY(IO_EXCEPTION, "overwrites the WHAT buffer");
+            }
+            CATCH()
+            {
+            }
+            END_TRY;
+        }
+        END_TRY;
+    }
+    CATCH(e)
+    {
+        caught = e == PARSE_EXCEPTION && strcmp(WHAT, "line 12") == 0;
+    }
+    END_TRY;
+    check(caught, "exception handled in finally", __LINE__);
+
+    // A payload survives the `FINALLY` clauses it goes through
+    caught = 0;
+    TRY
+    {
+        TRY
+        {
+            THROW(IO_EXCEPTION);
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            THROW_WITH(PARSE_EXCEPTION, int, 1234);
+        }
+        FINALLY
+        {
+            ON_UNWIND(record, "p");
+        }
+        END_TRY;
+    }
+    CATCH_PAYLOAD(PARSE_EXCEPTION, int, value)
+    {
+        caught = value != NULL && *value == 1234;
+    }
+    END_TRY;
+    check(caught, "payload through finally", __LINE__);
+
+    // A message longer than the arena is kept (truncated) through the `FINALLY` clauses it goes through
+    static char long_what[EXCEPT_ARENA_SIZE + 512];
+    memset(long_what, 'w', sizeof(long_what) - 1);
+    caught = 0;
+    TRY
+    {
+        TRY
+        {
+            THROW(IO_EXCEPTION);
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            THROW_COPY(PARSE_EXCEPTION, long_what);
+        }
+        FINALLY
+        {
+        }
+        END_TRY;
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        size_t length = strlen(WHAT);
+        caught = length > 0 && length < sizeof(long_what) - 1 && strncmp(WHAT, long_what, length) == 0;
+    }
+    END_TRY;
+    check(caught, "long message through finally", __LINE__);
+
+    // Cleanups run in reverse order of registration when the block ends, whichever way it ends
+    reset_order();
+    TRY
+    {
+        open_and_throw();
+    }
+    CATCH()
+    {
+    }
+    END_TRY;
+    check(strcmp(order, "fba") == 0, "cleanups after an exception", __LINE__);
+
+    reset_order();
+    TRY
+    {
+        ON_UNWIND(record, "x");
+        TRY
+        {
+            ON_UNWIND(record, "y");
+        }
+        END_TRY;
+        record("z");
+    }
+    END_TRY;
+    check(strcmp(order, "yzx") == 0, "cleanups on normal exit", __LINE__);
+
+    // Blocks whose exception is not caught are popped as well
+    volatile int unmatched = 0;
+    for (volatile int i = 0; i < 100; i++)
+    {
+        TRY
+        {
+            THROW(PARSE_EXCEPTION);
+        }
+        CATCH(IO_EXCEPTION)
+        {
+        }
+        END_TRY;
+        ++unmatched;
+    }
+    check(unmatched == 100 && exC_get_context()->top == 0, "blocks without a matching catch", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define PARSE_EXCEPTION 2
+#define FATAL_EXCEPTION 3
+
+static char output[8192];
+
+// What `exC_print_flight_recorder` prints
+static const char* print_events(void)
+{
+    output[0] = '\0';
+    FILE* stream = tmpfile();
+    if (stream == NULL)
+        return output;
+    exC_print_flight_recorder(stream);
+    rewind(stream);
+    size_t size = fread(output, 1, sizeof(output) - 1, stream);
+    output[size] = '\0';
+    fclose(stream);
+    return output;
+}
+
+#if defined(EXCEPT_FLIGHT_RECORDER)
+// Whether `events` are printed in this order
+static int printed_in_order(const char* printed, const char* const* events, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        printed = strstr(printed, events[i]);
+        if (printed == NULL)
+            return 0;
+        printed += strlen(events[i]);
+    }
+    return 1;
+}
+#endif
+
+static void on_terminate(int status)
+{
+    (void)status;
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    // The uncaught exception is recorded before the handler is called
+    const char* const events[] = { " throw 3 ", " terminate 3 " };
+    check(printed_in_order(print_events(), events, 2), "uncaught exception recorded", __LINE__);
+#endif
+    exit(check_status());
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    TRY
+    {
+        THROW(IO_EXCEPTION, "open failed");
+    }
+    CATCH(IO_EXCEPTION)
+    {
+    }
+    END_TRY;
+    TRY
+    {
+        TRY
+        {
+            THROWF(PARSE_EXCEPTION, "line %d", 3);
+        }
+        CATCH()
+        {
+            THROW();
+        }
+        END_TRY;
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+    }
+    END_TRY;
+
+#if defined(EXCEPT_FLIGHT_RECORDER)
+    const char* const events[] = { "thread 1", " throw 1 what ", " depth 1 ", " catch 1 ", " throw 2 ", " depth 2 ", " catch 2 ",
+                                   " rethrow 2 ", " catch 2 " };
+    check(printed_in_order(print_events(), events, sizeof(events) / sizeof(events[0])), "events recorded", __LINE__);
+
+    // Only the last events are kept
+    for (volatile int i = 0; i < 100; i++)
+    {
+        TRY
+        {
+            THROW(IO_EXCEPTION);
+        }
+        CATCH()
+        {
+        }
+        END_TRY;
+    }
+    const char* printed = print_events();
+    check(strstr(printed, "#0 ") == NULL && strstr(printed, "#205 catch 1 ") != NULL, "oldest events overwritten", __LINE__);
+#else
+    check(print_events()[0] == '\0', "nothing recorded without EXCEPT_FLIGHT_RECORDER", __LINE__);
+#endif
+
+    // Never returns
+    exC_set_term_handler(on_terminate);
+    THROW(FATAL_EXCEPTION, "uncaught");
+}
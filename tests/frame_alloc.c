@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define PARSE_EXCEPTION 1
+
+// Copies `token` in frame memory, and throws once it is there
+static void parse_token(const char* token, size_t size)
+{
+    char* copy = exC_frame_alloc(size);
+    if (copy == NULL)
+        THROW(PARSE_EXCEPTION, "out of memory");
+    memset(copy, 'x', size);
+    strncpy(copy, token, size - 1);
+    copy[size - 1] = '\0';
+    THROW(PARSE_EXCEPTION, "unexpected token");
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    check(exC_frame_alloc(16) == NULL, "frame memory outside of a block", __LINE__);
+
+    // Frame memory is aligned and usable until the block ends
+    volatile int usable = 0;
+    TRY
+    {
+        double* numbers = exC_frame_alloc(4 * sizeof(double));
+        char* small = exC_frame_alloc(3);
+        long double* aligned = exC_frame_alloc(sizeof(long double));
+        usable = numbers != NULL && small != NULL && aligned != NULL
+              && (uintptr_t) aligned % _Alignof(long double) == 0;
+        if (usable)
+        {
+            numbers[3] = 4.5;
+            memcpy(small, "ok", 3);
+            *aligned = 1.5L;
+            usable = numbers[3] == 4.5 && strcmp(small, "ok") == 0 && *aligned == 1.5L;
+        }
+    }
+    END_TRY;
+    check(usable, "frame memory", __LINE__);
+    check(exC_get_context()->records == NULL, "frame memory released on normal exit", __LINE__);
+
+    // Released by every block it is thrown through, be it from the arena or from `malloc` (leaks show with ASan)
+    volatile int caught = 0;
+    for (volatile int i = 0; i < 1000; i++)
+    {
+        TRY
+        {
+            parse_token("while", (size_t) (i % 2 != 0 ? 16 : 4 * EXCEPT_ARENA_SIZE));
+        }
+        CATCH(PARSE_EXCEPTION)
+        {
+            caught += exC_frame_alloc(EXCEPT_ARENA_SIZE / 4) != NULL;
+        }
+        END_TRY;
+    }
+    check(caught == 1000, "frame memory released after a throw", __LINE__);
+    check(exC_get_context()->records == NULL, "frame memory released after a throw", __LINE__);
+
+    // A message in frame memory outlives the block thrown out of (use-after-free shows with ASan)
+    volatile int message_kept = 0;
+    TRY
+    {
+        TRY {}
+        FINALLY
+        {
+            char* message = exC_frame_alloc(4096);
+            strcpy(message, "message in frame memory");
+            THROW(PARSE_EXCEPTION, message);
+        }
+        END_TRY;
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        message_kept = strcmp(WHAT, "message in frame memory") == 0;
+    }
+    END_TRY;
+    check(message_kept, "message in frame memory", __LINE__);
+
+    // Same with a formatted message whose arguments are in frame memory
+    volatile int arguments_kept = 0;
+    TRY
+    {
+        TRY {}
+        FINALLY
+        {
+            char* token = exC_frame_alloc(16);
+            strcpy(token, "while");
+            THROWF(PARSE_EXCEPTION, "unexpected token %s", token);
+        }
+        END_TRY;
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        arguments_kept = strcmp(WHAT, "unexpected token while") == 0;
+    }
+    END_TRY;
+    check(arguments_kept, "formatted message with arguments in frame memory", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+
+static int cleanups = 0;
+
+static void cleanup(void* arg)
+{
+    (void)arg;
+    cleanups++;
+}
+
+static int outer_caught = 0;
+
+static void on_terminate(int status)
+{
+    (void)status;
+    // The enclosing block never sees the exception
+    check(!outer_caught, "exception left the NOEXCEPT block", __LINE__);
+    exit(check_status());
+}
+
+static int sum(int count)
+{
+    volatile int total = 0; // With EXCEPT_DEBUG_NOEXCEPT, the block calls `setjmp`
+    NOEXCEPT
+    {
+        for (int i = 1; i <= count; i++)
+            total += i;
+    }
+    END_NOEXCEPT;
+    return total;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    check(sum(10) == 55 && EXCEPT_CONTEXT()->top == 0, "NOEXCEPT block left", __LINE__);
+
+    // Exceptions caught within the block are fine, and its cleanups run when it ends
+    volatile int caught = 0;
+    NOEXCEPT
+    {
+        ON_UNWIND(cleanup, NULL);
+        TRY
+        {
+            THROW(IO_EXCEPTION, "inside");
+        }
+        CATCH(IO_EXCEPTION)
+        {
+            caught = 1;
+        }
+        END_TRY;
+    }
+    END_NOEXCEPT;
+    check(caught && cleanups == 1 && EXCEPT_CONTEXT()->top == 0, "exception caught inside", __LINE__);
+
+#if !defined(EXCEPT_DEBUG_NOEXCEPT) && (defined(__GNUC__) || defined(__clang__))
+    // Leaving the block with `break` or `continue` pops its marker too
+    int iterations = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        NOEXCEPT
+        {
+            iterations++;
+            if (i % 2 == 0)
+                continue;
+            if (i == 5)
+                break;
+        }
+        END_NOEXCEPT;
+    }
+    check(iterations == 6 && EXCEPT_CONTEXT()->top == 0, "NOEXCEPT block left by break or continue", __LINE__);
+    caught = 0;
+    TRY
+    {
+        THROW(IO_EXCEPTION, "after the loop");
+    }
+    CATCH(IO_EXCEPTION)
+    {
+        caught = 1;
+    }
+    END_TRY;
+    check(caught && EXCEPT_CONTEXT()->top == 0, "exception caught after the loop", __LINE__);
+#endif
+
+    // Never returns
+    exC_set_term_handler(on_terminate);
+    TRY
+    {
+        NOEXCEPT
+        {
+            THROW(IO_EXCEPTION, "escaping");
+        }
+        END_NOEXCEPT;
+    }
+    CATCH()
+    {
+        outer_caught = 1;
+    }
+    END_TRY;
+    check(0, "not terminated", __LINE__);
+    return check_status();
+}
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define PARSE_EXCEPTION 1
+#define IO_EXCEPTION 2
+
+struct parse_error
+{
+    int line;
+    int column;
+    const char* token;
+};
+
+static void parse(int line)
+{
+    THROW_WITH(PARSE_EXCEPTION, struct parse_error, ((struct parse_error){ line, 7, "}" }));
+}
+
+static void parse_and_rethrow(int line)
+{
+    TRY
+    {
+        parse(line);
+    }
+    CATCH()
+    {
+        THROW();
+    }
+    END_TRY;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    // The payload reaches the `CATCH` clause
+    volatile int caught = 0;
+    TRY
+    {
+        parse(42);
+    }
+    CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, err)
+    {
+        caught = err != NULL && err->line == 42 && err->column == 7 && err->token[0] == '}';
+    }
+    END_TRY;
+    check(caught, "payload not received", __LINE__);
+
+    // No payload, or not of the expected type
+    caught = 0;
+    TRY
+    {
+        THROW(PARSE_EXCEPTION);
+    }
+    CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, err)
+    {
+        caught = err == NULL;
+    }
+    END_TRY;
+    check(caught, "payload of a plain THROW is not NULL", __LINE__);
+    caught = 0;
+    TRY
+    {
+        THROW_WITH(IO_EXCEPTION, int, 5);
+    }
+    CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, err)
+    {
+        (void)err;
+    }
+    CATCH_PAYLOAD(IO_EXCEPTION, char, c)
+    {
+        caught = c == NULL;
+    }
+    END_TRY;
+    check(caught, "payload of the wrong size is not NULL", __LINE__);
+
+    // A payload stays valid while exceptions with their own payloads are handled in its `CATCH` clause
+    caught = 0;
+    TRY
+    {
+        parse(1);
+    }
+    CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, outer)
+    {
+        TRY
+        {
+            THROW_WITH(IO_EXCEPTION, long, 99L);
+        }
+        CATCH_PAYLOAD(IO_EXCEPTION, long, inner)
+        {
+            caught = inner != NULL && *inner == 99L;
+        }
+        END_TRY;
+        caught = caught && outer != NULL && outer->line == 1;
+    }
+    END_TRY;
+    check(caught, "nested payloads", __LINE__);
+
+    // Rethrowing keeps the payload
+    caught = 0;
+    TRY
+    {
+        parse_and_rethrow(3);
+    }
+    CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, err)
+    {
+        caught = err != NULL && err->line == 3;
+    }
+    END_TRY;
+    check(caught, "payload lost when rethrown", __LINE__);
+
+    // The arena is released after each `CATCH` clause
+    volatile int received = 0;
+    for (volatile int i = 0; i < 10 * EXCEPT_ARENA_SIZE; i++)
+    {
+        TRY
+        {
+            parse(i);
+        }
+        CATCH_PAYLOAD(PARSE_EXCEPTION, struct parse_error, err)
+        {
+            received += err != NULL && err->line == i;
+        }
+        END_TRY;
+    }
+    check(received == 10 * EXCEPT_ARENA_SIZE, "payload arena not released", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,96 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define CACHE_MISS 1
+#define PARSE_EXCEPTION 2
+
+__attribute__((noinline)) static void lookup(volatile int key)
+{
+    if (key >= 0)
+        THROW(CACHE_MISS, "not cached");
+}
+
+__attribute__((noinline)) static void lookups(int count)
+{
+    for (volatile int i = 0; i < count; i++)
+    {
+        TRY
+        {
+            lookup(i);
+        }
+        CATCH(CACHE_MISS)
+        {
+        }
+        END_TRY;
+    }
+}
+
+static exC_sample_t samples[256];
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+#if defined(EXCEPT_SAMPLING)
+    // One throw out of 10
+    check(exC_sample_every(10) == 0, "sample every", __LINE__);
+    lookups(100);
+    size_t count = exC_samples_drain(samples, 256);
+    check(count == 10, "every 10th throw sampled", __LINE__);
+    check(samples[0].code == CACHE_MISS && samples[0].thread == 1 && samples[0].time != 0, "sample", __LINE__);
+    check(samples[0].time <= samples[count - 1].time, "samples in order", __LINE__);
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    // The innermost frame is the throw site (`lookups` if `lookup` was inlined in it)
+    uintptr_t site = samples[0].depth != 0 ? (uintptr_t) samples[0].frames[0] : 0;
+    check((site > (uintptr_t) lookup && site < (uintptr_t) lookup + 256)
+          || (site > (uintptr_t) lookups && site < (uintptr_t) lookups + 512), "backtrace of the throw site", __LINE__);
+#endif
+    check(exC_samples_drain(samples, 256) == 0, "drained", __LINE__);
+
+    // Samples are dropped when the ring is full
+    check(exC_sample_every(1) == 0, "sample every throw", __LINE__);
+    lookups(200);
+    count = exC_samples_drain(samples, 256);
+    check(count > 0 && count < 200, "full ring", __LINE__);
+
+    // A high rate samples every throw
+    check(exC_sample_rate(1e9) == 0, "sample rate", __LINE__);
+    lookups(5);
+    check(exC_samples_drain(samples, 256) == 5, "sampled at a rate", __LINE__);
+    check(exC_sample_rate(-1) != 0, "negative rate", __LINE__);
+
+    // Identical stacks are merged, the exception being the leaf
+    check(exC_sample_every(1) == 0, "sample every throw", __LINE__);
+    lookups(3);
+    FILE* stream = tmpfile();
+    check(stream != NULL && exC_samples_write_collapsed(stream) == 0, "write collapsed stacks", __LINE__);
+    char line[1024] = "";
+    if (stream != NULL)
+    {
+        rewind(stream);
+        if (fgets(line, sizeof(line), stream) == NULL)
+            line[0] = '\0';
+        fclose(stream);
+    }
+    check(strstr(line, "exception:1 3\n") != NULL, "collapsed stack", __LINE__);
+
+    check(exC_sample_every(0) == 0, "stop sampling", __LINE__);
+    lookups(10);
+    check(exC_samples_drain(samples, 256) == 0, "sampling stopped", __LINE__);
+#else
+    lookups(10);
+    check(exC_sample_every(1) != 0 && exC_sample_rate(1) != 0, "no sampling without EXCEPT_SAMPLING", __LINE__);
+    check(exC_samples_drain(samples, 256) == 0 && exC_samples_write_collapsed(stdout) != 0, "no samples", __LINE__);
+#endif
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
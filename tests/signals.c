@@ -0,0 +1,141 @@
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+static volatile int* volatile null_pointer = NULL;
+static volatile int one = 1;
+static volatile int zero = 0;
+
+static volatile unsigned long max_depth = (unsigned long) -1;
+
+// Never returns : the stack overflows first
+static unsigned long recurse(unsigned long depth)
+{
+    if (depth == max_depth)
+        return 0;
+    volatile char frame[256];
+    frame[0] = (char) depth;
+    return recurse(depth + 1) + (unsigned long) frame[0];
+}
+
+static int read_null(void)
+{
+    return *null_pointer;
+}
+
+// Handler installed before `exC_signals_install`
+static sigjmp_buf previous_env;
+
+static void previous_handler(int signum, siginfo_t* info, void* ucontext)
+{
+    (void)info;
+    (void)ucontext;
+    siglongjmp(previous_env, signum);
+}
+#endif
+
+int main(void)
+{
+    check(exC_signals_install() != 0, "no signal bridge before thread setup", __LINE__);
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+    check(exC_signals_install() == 0, "signal bridge installed", __LINE__);
+    check(exC_signals_install() == 0, "installed twice", __LINE__);
+
+    // The fault address is the payload
+    volatile int caught = 0;
+    TRY
+    {
+        caught = read_null();
+    }
+    CATCH_PAYLOAD(EXCEPT_SEGMENTATION_FAULT, exC_fault_t, fault)
+    {
+        caught = fault != NULL && fault->signal == SIGSEGV && fault->address == NULL
+                 && strcmp(WHAT, "Segmentation fault") == 0;
+    }
+    END_TRY;
+    check(caught, "null pointer dereference", __LINE__);
+
+    // The signal is not left blocked : the next fault is caught too
+    caught = 0;
+    TRY
+    {
+        TRY
+        {
+            read_null();
+        }
+        FINALLY
+        {
+            caught = 1;
+        }
+        END_TRY;
+        read_null();
+    }
+    CATCH_ANY_OF(EXCEPT_SEGMENTATION_FAULT)
+    {
+        caught++;
+    }
+    END_TRY;
+    check(caught == 2, "second fault", __LINE__);
+
+    // The handler runs on the alternate stack
+    caught = 0;
+    TRY
+    {
+        recurse(0);
+    }
+    CATCH_ANY_OF(EXCEPT_SEGMENTATION_FAULT)
+    {
+        caught = 1;
+    }
+    END_TRY;
+    check(caught, "stack overflow", __LINE__);
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Integer division by zero only traps on x86
+    caught = 0;
+    TRY
+    {
+        caught = one / zero;
+    }
+    CATCH_PAYLOAD(EXCEPT_ARITHMETIC_FAULT, exC_fault_t, fault)
+    {
+        caught = fault != NULL && fault->signal == SIGFPE && fault->code == FPE_INTDIV;
+    }
+    END_TRY;
+    check(caught, "division by zero", __LINE__);
+#endif
+
+    // Outside of any `TRY` block, the fault goes to the handler the bridge replaced
+    exC_signals_uninstall();
+    struct sigaction previous = { .sa_sigaction = previous_handler, .sa_flags = SA_SIGINFO | SA_ONSTACK };
+    sigemptyset(&previous.sa_mask);
+    sigaction(SIGSEGV, &previous, NULL);
+    check(exC_signals_install() == 0, "signal bridge installed again", __LINE__);
+    if (sigsetjmp(previous_env, 1) == 0)
+    {
+        read_null();
+        check(0, "fault outside of a block", __LINE__);
+    }
+    exC_signals_uninstall();
+    struct sigaction restored;
+    sigaction(SIGSEGV, NULL, &restored);
+    check((restored.sa_flags & SA_SIGINFO) && restored.sa_sigaction == previous_handler, "previous handler restored",
+          __LINE__);
+#else
+    check(exC_signals_install() != 0, "no signal bridge on this platform", __LINE__);
+#endif
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define STACK_SIZE 100
+#define RECURSION_EXCEPTION 1
+
+// Nests `depth` blocks, and throws from the innermost one if `do_throw` is set
+static void recurse(int depth, int do_throw)
+{
+    TRY
+    {
+        if (depth == 1 && do_throw)
+            THROW(RECURSION_EXCEPTION);
+        if (depth > 1)
+            recurse(depth - 1, do_throw);
+    }
+    CATCH()
+    {
+        // Rethrown up to the outermost block (unhandled exceptions are not propagated)
+        THROW();
+    }
+    END_TRY;
+}
+
+int main(void)
+{
+    exC_global_setup(STACK_SIZE, 0);
+    exC_thrd_setup();
+
+    // The stack grows up to its limit
+    volatile int caught = 0;
+    TRY
+    {
+        recurse(STACK_SIZE - 1, 1);
+    }
+    CATCH(RECURSION_EXCEPTION)
+    {
+        caught = 1;
+    }
+    END_TRY;
+    check(caught, "RECURSION_EXCEPTION not caught", __LINE__);
+
+    // One more block overflows the stack : the outermost block recovers
+    caught = 0;
+    TRY
+    {
+        recurse(STACK_SIZE, 0);
+    }
+    CATCH_ANY_OF(EXCEPT_STACK_OVERFLOW)
+    {
+        caught = 1;
+    }
+    CATCH(e)
+    {
+        fprintf(stderr, "Unexpected exception %llu\n", (unsigned long long) e);
+    }
+    END_TRY;
+    check(caught, "EXCEPT_STACK_OVERFLOW not caught", __LINE__);
+
+    // And the stack is still usable afterwards
+    caught = 0;
+    TRY
+    {
+        recurse(STACK_SIZE / 2, 1);
+    }
+    CATCH(RECURSION_EXCEPTION)
+    {
+        caught = 1;
+    }
+    END_TRY;
+    check(caught, "RECURSION_EXCEPTION not caught after overflow", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
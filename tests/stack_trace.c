@@ -0,0 +1,55 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define PARSE_EXCEPTION 1
+
+__attribute__((noinline)) static void next_token(volatile int* token)
+{
+    if (*token == '}')
+        THROW(PARSE_EXCEPTION, "unexpected token");
+    ++*token;
+}
+
+__attribute__((noinline)) static int parse(volatile int token)
+{
+    next_token(&token);
+    return token;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    void* const* frames = NULL;
+    volatile size_t size = 0;
+    TRY
+    {
+        parse('}');
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+        size = exC_stack_trace(&frames);
+        STACK_TRACE(stdout);
+    }
+    END_TRY;
+#if defined(EXCEPT_CAPTURE_STACK_TRACE) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+    // The first frame is the throw site : `next_token`, or `parse` if the throwing function was inlined in `next_token`
+    // (the frames above it are only found in code built with frame pointers)
+    check(size != 0 && size <= 32, "stack trace captured", __LINE__);
+    uintptr_t site = size != 0 ? (uintptr_t) frames[0] : 0;
+    check((site > (uintptr_t) next_token && site < (uintptr_t) next_token + 256)
+          || (site > (uintptr_t) parse && site < (uintptr_t) parse + 256), "stack trace of the throw site", __LINE__);
+#else
+    check(size == 0, "no stack trace without EXCEPT_CAPTURE_STACK_TRACE", __LINE__);
+#endif
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
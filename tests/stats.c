@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(EXCEPT_ONE_THREAD)
+    #include <threads.h>
+#endif
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+#define PARSE_EXCEPTION 2
+
+static const exC_code_stats_t* find_code(const exC_stats_t* stats, EXCEPT_EXCEPTION_TYPE code)
+{
+    for (size_t i = 0; i < stats->code_count; i++)
+    {
+        if (stats->codes[i].code == code)
+            return &stats->codes[i];
+    }
+    return NULL;
+}
+
+static int read_line = 0;
+
+static void read_file(void)
+{
+    read_line = __LINE__ + 1;
+    THROW(IO_EXCEPTION, "read failed");
+}
+
+static void read_files(void)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        TRY
+        {
+            read_file();
+        }
+        CATCH(IO_EXCEPTION)
+        {
+        }
+        END_TRY;
+    }
+}
+
+#if !defined(EXCEPT_ONE_THREAD)
+static int worker(void* arg)
+{
+    (void)arg;
+    exC_thrd_setup();
+    read_files();
+    exC_thrd_deinit();
+    return 0;
+}
+#endif
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    read_files();
+#if !defined(EXCEPT_ONE_THREAD)
+    // The counts of threads that ended are kept
+    thrd_t thread;
+    if (thrd_create(&thread, worker, NULL) == thrd_success)
+        thrd_join(thread, NULL);
+    unsigned long long reads = 10;
+#else
+    unsigned long long reads = 5;
+#endif
+
+    TRY
+    {
+        TRY
+        {
+            THROWF(PARSE_EXCEPTION, "line %d", 3);
+        }
+        CATCH()
+        {
+            THROW();
+        }
+        END_TRY;
+    }
+    CATCH(PARSE_EXCEPTION)
+    {
+    }
+    END_TRY;
+
+    exC_stats_t stats;
+#if defined(EXCEPT_STATS)
+    check(exC_stats_snapshot(&stats) == 0, "snapshot", __LINE__);
+    const exC_code_stats_t* io = find_code(&stats, IO_EXCEPTION);
+    const exC_code_stats_t* parse = find_code(&stats, PARSE_EXCEPTION);
+    check(stats.code_count == 2 && stats.untracked == 0, "codes", __LINE__);
+    check(io != NULL && io->thrown == reads && io->caught == reads && io->rethrown == 0, "IO counts", __LINE__);
+    check(parse != NULL && parse->thrown == 1 && parse->caught == 2 && parse->rethrown == 1, "parse counts", __LINE__);
+    check(stats.codes[0].code == IO_EXCEPTION, "codes sorted by throws", __LINE__);
+    check(stats.site_count == 2 && stats.top_sites[0].line == read_line && stats.top_sites[0].thrown == reads
+          && strstr(stats.top_sites[0].file, "stats.c") != NULL, "top throw site", __LINE__);
+#else
+    (void)find_code;
+    (void)reads;
+    check(exC_stats_snapshot(&stats) != 0, "no statistics without EXCEPT_STATS", __LINE__);
+#endif
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,92 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define IO_EXCEPTION 1
+
+static atomic_int done = 0;
+
+static void count(void* arg)
+{
+    (void)arg;
+    atomic_fetch_add(&done, 1);
+}
+
+// Queues 10 tasks from a task
+static void fan_out(void* group)
+{
+    for (int i = 0; i < 10; i++)
+        exC_task_group_run(group, count, NULL);
+}
+
+static void read_block(void* arg)
+{
+    THROWF(IO_EXCEPTION, "block %d unreadable", *(int*) arg);
+}
+
+// Runs until the group is cancelled (at most 10 seconds)
+static atomic_int stopped = 0;
+
+static void scan(void* group)
+{
+    time_t start = time(NULL);
+    while (!exC_task_group_cancelled(group) && time(NULL) - start < 10)
+        ;
+    if (exC_task_group_cancelled(group))
+        atomic_fetch_add(&stopped, 1);
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    // Worker threads and the waiting thread run every task, including the ones queued by tasks
+    exC_task_group_t* group = exC_task_group_create(3);
+    check(group != NULL, "group created", __LINE__);
+    for (int i = 0; i < 100; i++)
+        exC_task_group_run(group, count, NULL);
+    for (int i = 0; i < 5; i++)
+        exC_task_group_run(group, fan_out, group);
+    volatile int thrown = 0;
+    TRY
+    {
+        exC_task_group_wait(group);
+    }
+    CATCH()
+    {
+        thrown = 1;
+    }
+    END_TRY;
+    check(!thrown && atomic_load(&done) == 150, "all tasks run", __LINE__);
+
+    // The first exception cancels the other tasks, and is thrown by `exC_task_group_wait`
+    group = exC_task_group_create(3);
+    int block = 42;
+    exC_task_group_run(group, scan, group);
+    exC_task_group_run(group, scan, group);
+    exC_task_group_run(group, read_block, &block);
+    volatile int caught = 0;
+    TRY
+    {
+        exC_task_group_wait(group);
+    }
+    CATCH(IO_EXCEPTION)
+    {
+        caught = strcmp(WHAT, "block 42 unreadable") == 0;
+    }
+    END_TRY;
+    check(caught, "exception of the task", __LINE__);
+    // Without threads, the tasks queued first run last, and are skipped
+    check(atomic_load(&stopped) == 2 || atomic_load(&stopped) == 0, "cancelled tasks", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
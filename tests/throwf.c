@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+#define KEY_NOT_FOUND_EXCEPTION 1
+
+static void check_what(const char* expected, int line)
+{
+    if (strcmp(WHAT, expected) != 0)
+    {
+        fprintf(stderr, "line %d: expected \"%s\", got \"%s\"\n", line, expected, WHAT);
+        failures++;
+    }
+}
+
+static void lookup(const char* key, size_t offset)
+{
+    // The key is a temporary buffer, which is gone when the exception is caught
+    char copy[32];
+    snprintf(copy, sizeof(copy), "%s", key);
+    THROWF(KEY_NOT_FOUND_EXCEPTION, "key '%s' not found at offset %zu (%-4d|%5.2f|%x|%*d|%%|%lld|%c)",
+           copy, offset, -7, 3.14159, 255u, 3, 9, -1234567890123LL, 'z');
+}
+
+static void lookup_many(void)
+{
+    // More arguments than can be captured : formatted right away
+    THROWF(KEY_NOT_FOUND_EXCEPTION, "%d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+}
+
+int main(void)
+{
+    exC_global_setup(42, 0);
+    exC_thrd_setup();
+
+    TRY
+    {
+        lookup("answer", 42);
+    }
+    CATCH(KEY_NOT_FOUND_EXCEPTION)
+    {
+        check_what("key 'answer' not found at offset 42 (-7  | 3.14|ff|  9|%|-1234567890123|z)", __LINE__);
+        // Already formatted, but reading it again must not change it
+        check_what("key 'answer' not found at offset 42 (-7  | 3.14|ff|  9|%|-1234567890123|z)", __LINE__);
+    }
+    END_TRY;
+
+    TRY
+    {
+        lookup_many();
+    }
+    CATCH(KEY_NOT_FOUND_EXCEPTION)
+    {
+        check_what("1 2 3 4 5 6 7 8 9 10", __LINE__);
+    }
+    END_TRY;
+
+    TRY
+    {
+        THROWF(KEY_NOT_FOUND_EXCEPTION, "no arguments");
+    }
+    CATCH(KEY_NOT_FOUND_EXCEPTION)
+    {
+        check_what("no arguments", __LINE__);
+    }
+    END_TRY;
+
+    // A message that is never read is never formatted, and does not leak into the next exception
+    TRY
+    {
+        lookup("unused", 0);
+    }
+    CATCH()
+    {
+    }
+    END_TRY;
+    TRY
+    {
+        THROW(KEY_NOT_FOUND_EXCEPTION);
+    }
+    CATCH(KEY_NOT_FOUND_EXCEPTION)
+    {
+        check_what("", __LINE__);
+    }
+    END_TRY;
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}
@@ -0,0 +1,83 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <exCept.h>
+
+#include "check.h"
+
+// Codes that do not fit in the value passed to `longjmp`, nor in the range chaos-pp can tell apart
+#define TOP_BIT ((EXCEPT_EXCEPTION_TYPE) 1 << (sizeof(EXCEPT_EXCEPTION_TYPE) * CHAR_BIT - 1))
+#define HIGH_FIVE (TOP_BIT | 5)
+// The largest value, -1, is `EXCEPT_UNWINDING`
+#define LARGEST ((EXCEPT_EXCEPTION_TYPE) -2)
+#define SUBSYSTEM_CODE EXCEPT_MAKE_CODE(0x7fff, 513)
+
+// Returns which clause caught `except`
+static int dispatch(EXCEPT_EXCEPTION_TYPE except)
+{
+    volatile int clause = 0;
+    TRY
+    {
+        THROW(except);
+    }
+    CATCH(5)
+    {
+        clause = 1;
+    }
+    CATCH_ANY_OF(HIGH_FIVE)
+    {
+        clause = 2;
+    }
+    CATCH_ANY_OF(LARGEST, SUBSYSTEM_CODE)
+    {
+        clause = 3;
+    }
+    CATCH(e)
+    {
+        clause = e == except ? 4 : -1;
+    }
+    END_TRY;
+    return clause;
+}
+
+// Rethrows `except` through one block, returning the exception seen by the outer one
+static EXCEPT_EXCEPTION_TYPE rethrown(EXCEPT_EXCEPTION_TYPE except)
+{
+    volatile EXCEPT_EXCEPTION_TYPE caught = 0;
+    TRY
+    {
+        TRY
+        {
+            THROW(except);
+        }
+        CATCH()
+        {
+            THROW();
+        }
+        END_TRY;
+    }
+    CATCH(e)
+    {
+        caught = e;
+    }
+    END_TRY;
+    return caught;
+}
+
+int main(void)
+{
+    exC_global_setup(10, 0);
+    exC_thrd_setup();
+
+    check(dispatch(5) == 1, "small code", __LINE__);
+    check(dispatch(HIGH_FIVE) == 2, "code sharing its low bits with another one", __LINE__);
+    check(dispatch(LARGEST) == 3, "largest code", __LINE__);
+    check(dispatch(SUBSYSTEM_CODE) == 3, "category code", __LINE__);
+    check(dispatch(TOP_BIT | 513) == 4, "uncaught wide code", __LINE__);
+    check(rethrown(HIGH_FIVE) == HIGH_FIVE, "rethrown wide code", __LINE__);
+
+    exC_thrd_deinit();
+    exC_global_deinit();
+    return check_status();
+}